@@ -452,6 +452,7 @@ void AdaptiveMeshSnapshot::path(SpatialGridPath* path) const
             wall = (kz<0.0) ? Node::BOTTOM : Node::TOP;
         }
         path->addSegment(node->cellIndex(), ds);
+        if (path->atSegmentLimit()) return;
         r += (ds+_eps)*(path->direction());
 
         // try the most likely neighbor of the current node, and use top-down search as a fall-back
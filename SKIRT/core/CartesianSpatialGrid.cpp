@@ -95,56 +95,60 @@ void CartesianSpatialGrid::path(SpatialGridPath* path) const
     int i = NR::locateClip(_xv, x);
     int j = NR::locateClip(_yv, y);
     int k = NR::locateClip(_zv, z);
-
-    // There we go...
-    double ds, dsx, dsy, dsz;
+    int m = index(i,j,k);
+
+    // Make room for the maximum number of segments so that they can be added without reallocation
+    path->reserve(_Nx+_Ny+_Nz);
+
+    // For each axis, determine the step in the cell indices, the offset of the next border in the mesh
+    // relative to the cell index, and the inverse of the direction component (or zero if the path does
+    // not advance along the axis)
+    int di = (kx<0.0) ? -1 : 1;
+    int dj = (ky<0.0) ? -1 : 1;
+    int dk = (kz<0.0) ? -1 : 1;
+    int oi = (kx<0.0) ? 0 : 1;
+    int oj = (ky<0.0) ? 0 : 1;
+    int ok = (kz<0.0) ? 0 : 1;
+    double ikx = (fabs(kx)>1e-15) ? 1./kx : 0.;
+    double iky = (fabs(ky)>1e-15) ? 1./ky : 0.;
+    double ikz = (fabs(kz)>1e-15) ? 1./kz : 0.;
+
+    // For each axis, determine the distance from the current position to the next cell border
+    double tx = ikx ? (_xv[i+oi]-x)*ikx : DBL_MAX;
+    double ty = iky ? (_yv[j+oj]-y)*iky : DBL_MAX;
+    double tz = ikz ? (_zv[k+ok]-z)*ikz : DBL_MAX;
+
+    // Step through the grid, each time crossing the nearest cell border; the distances to the cell borders
+    // are measured from the original position so that round-off errors do not accumulate along the path
+    double t = 0.;
     while (true)
     {
-        int m = index(i,j,k);
-        double xE = (kx<0.0) ? _xv[i] : _xv[i+1];
-        double yE = (ky<0.0) ? _yv[j] : _yv[j+1];
-        double zE = (kz<0.0) ? _zv[k] : _zv[k+1];
-        dsx = (fabs(kx)>1e-15) ? (xE-x)/kx : DBL_MAX;
-        dsy = (fabs(ky)>1e-15) ? (yE-y)/ky : DBL_MAX;
-        dsz = (fabs(kz)>1e-15) ? (zE-z)/kz : DBL_MAX;
-        if (dsx<=dsy && dsx<=dsz)
+        if (tx<=ty && tx<=tz)
         {
-            ds = dsx;
-            path->addSegment(m, ds);
-            i += (kx<0.0) ? -1 : 1;
-            if (i>=_Nx || i<0) return;
-            else
-            {
-                x = xE;
-                y += ky*ds;
-                z += kz*ds;
-            }
+            path->addSegment(m, tx-t);
+            i += di;
+            if (i>=_Nx || i<0 || path->atSegmentLimit()) return;
+            m += di*_Nz*_Ny;
+            t = tx;
+            tx = (_xv[i+oi]-x)*ikx;
         }
-        else if (dsy< dsx && dsy<=dsz)
+        else if (ty<=tz)
         {
-            ds = dsy;
-            path->addSegment(m, ds);
-            j += (ky<0.0) ? -1 : 1;
-            if (j>=_Ny || j<0) return;
-            else
-            {
-                x += kx*ds;
-                y = yE;
-                z += kz*ds;
-            }
+            path->addSegment(m, ty-t);
+            j += dj;
+            if (j>=_Ny || j<0 || path->atSegmentLimit()) return;
+            m += dj*_Nz;
+            t = ty;
+            ty = (_yv[j+oj]-y)*iky;
         }
-        else if (dsz< dsx && dsz< dsy)
+        else
         {
-            ds = dsz;
-            path->addSegment(m, ds);
-            k += (kz<0.0) ? -1 : 1;
-            if (k>=_Nz || k<0) return;
-            else
-            {
-                x += kx*ds;
-                y += ky*ds;
-                z  = zE;
-            }
+            path->addSegment(m, tz-t);
+            k += dk;
+            if (k>=_Nz || k<0 || path->atSegmentLimit()) return;
+            m += dk;
+            t = tz;
+            tz = (_zv[k+ok]-z)*ikz;
         }
     }
 }
@@ -79,7 +79,18 @@ public:
 
     /** This function calculates a path through the grid. The SpatialGridPath object passed as an
         argument specifies the starting position \f${\bf{r}}\f$ and the direction \f${\bf{k}}\f$
-        for the path. The data on the calculated path are added back into the same object. */
+        for the path. The data on the calculated path are added back into the same object.
+
+        The function uses a three-dimensional digital differential analyzer (Amanatides & Woo
+        1987, Eurographics 87, pp 3-10) that has been generalized to nonuniform meshes. For each
+        coordinate axis, it keeps track of the distance along the path from the starting point to
+        the next cell border perpendicular to that axis. In each step, the function crosses the
+        nearest of these three borders, adds the corresponding segment to the path, updates the
+        cell indices and the cell number by a constant increment, and calculates the distance to
+        the following border along the same axis. The distances are always measured from the
+        starting point, so that round-off errors do not accumulate along the path. Because a path
+        crosses at most \f$N_x+N_y+N_z\f$ cells, the function reserves room for this number of
+        segments in the path before starting the traversal. */
     void path(SpatialGridPath* path) const override;
 
 protected:
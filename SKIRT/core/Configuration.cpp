@@ -80,6 +80,12 @@ void Configuration::setupSelfBefore()
         _minWeightReduction = ms->photonPacketOptions()->minWeightReduction();
         _minScattEvents = ms->photonPacketOptions()->minScattEvents();
         _pathLengthBias = ms->photonPacketOptions()->pathLengthBias();
+        _singlePrecisionRadiationField = ms->photonPacketOptions()->singlePrecisionRadiationField();
+        _threadPrivateRadiationField = ms->photonPacketOptions()->threadPrivateRadiationField()
+                                       || _singlePrecisionRadiationField;
+        _skipEmptySpace = ms->photonPacketOptions()->skipEmptySpace();
+        _truncatePaths = ms->photonPacketOptions()->truncatePaths();
+        _groupWavelengths = _oligochromatic && ms->photonPacketOptions()->groupWavelengths();
     }
 
     // retrieve extinction-only options
@@ -119,6 +125,12 @@ void Configuration::setupSelfBefore()
             _storeEmissionRadiationField = true;
             _hasSecondaryRadiationField = true;
         }
+        if (ms->dustEmissionOptions()->precalculateEmissionSpectra())
+        {
+            _precalculateEmissionSpectra = true;
+            _maxEmissionSpectraMemory = ms->dustEmissionOptions()->maxEmissionSpectraMemory();
+            _emissionSpectrumReuseThreshold = ms->dustEmissionOptions()->emissionSpectrumReuseThreshold();
+        }
         _numSecondaryPackets = sim->numPackets() * ms->dustEmissionOptions()->secondaryPacketsMultiplier();
         _secondarySpatialBias = ms->dustEmissionOptions()->spatialBias();
         _secondaryWavelengthBias = ms->dustEmissionOptions()->wavelengthBias();
@@ -135,6 +147,8 @@ void Configuration::setupSelfBefore()
         _maxFractionOfPrimary = ms->dustSelfAbsorptionOptions()->maxFractionOfPrimary();
         _maxFractionOfPrevious = ms->dustSelfAbsorptionOptions()->maxFractionOfPrevious();
         _numIterationPackets = sim->numPackets() * ms->dustSelfAbsorptionOptions()->iterationPacketsMultiplier();
+        _initialIterationPacketsFraction = ms->dustSelfAbsorptionOptions()->initialIterationPacketsFraction();
+        _accelerateIterations = ms->dustSelfAbsorptionOptions()->accelerateIterations();
     }
 
     // retrieve symmetry dimensions
@@ -130,6 +130,27 @@ public:
         distribution. */
     double pathLengthBias() const { return _pathLengthBias; }
 
+    /** Returns true if the radiation field must be accumulated in a private table for each
+        execution thread, and false if all threads accumulate into a shared table. This is always
+        the case if the shared radiation field tables are stored in single precision. */
+    bool threadPrivateRadiationField() const { return _threadPrivateRadiationField; }
+
+    /** Returns true if the shared radiation field tables must be stored in single precision, and
+        false otherwise. */
+    bool singlePrecisionRadiationField() const { return _singlePrecisionRadiationField; }
+
+    /** Returns true if the spatial grid may cross regions without material in a single step when
+        calculating paths for which no radiation field needs to be stored, and false otherwise. */
+    bool skipEmptySpace() const { return _skipEmptySpace; }
+
+    /** Returns true if photon packet paths must be calculated only up to the interaction point in
+        simulation segments that do not store the radiation field, and false otherwise. */
+    bool truncatePaths() const { return _truncatePaths; }
+
+    /** Returns true if each primary emission event in an oligochromatic simulation must launch a
+        group of photon packets, one for each discrete wavelength, and false otherwise. */
+    bool groupWavelengths() const { return _groupWavelengths; }
+
     /** Returns the number of random density samples for determining spatial cell mass. */
     int numDensitySamples() const { return _numDensitySamples; }
 
@@ -168,6 +189,21 @@ public:
         otherwise. */
     bool storeEmissionRadiationField() const { return _storeEmissionRadiationField; }
 
+    /** Returns true if the dust emission spectra for all library entries must be calculated in
+        advance of each secondary emission segment, and false if they must be calculated on the fly
+        while launching photon packets. */
+    bool precalculateEmissionSpectra() const { return _precalculateEmissionSpectra; }
+
+    /** Returns the maximum amount of memory, in GB, to be used for storing the precalculated dust
+        emission spectra. If more memory would be needed, the spectra are calculated on the fly
+        instead. */
+    double maxEmissionSpectraMemory() const { return _maxEmissionSpectraMemory; }
+
+    /** Returns the relative change in the radiation field of a library entry below which the dust
+        emission spectrum precalculated for a previous segment is reused rather than recalculated,
+        or zero if the spectra must always be recalculated. */
+    double emissionSpectrumReuseThreshold() const { return _emissionSpectrumReuseThreshold; }
+
     /** Returns the cell library mapping to be used for calculating the dust emission spectra. */
     SpatialCellLibrary* cellLibrary() const { return _cellLibrary; }
 
@@ -198,6 +234,15 @@ public:
         this fraction compared to the previous iteration. */
     double maxFractionOfPrevious() const { return _maxFractionOfPrevious; }
 
+    /** Returns the fraction of the number of iteration photon packets launched for the first
+        self-absorption iteration. A value smaller than one enables the adaptive packet schedule
+        described in the DustSelfAbsorptionOptions class. */
+    double initialIterationPacketsFraction() const { return _initialIterationPacketsFraction; }
+
+    /** Returns true if the secondary radiation field should be extrapolated between
+        self-absorption iterations to accelerate convergence, and false otherwise. */
+    bool accelerateIterations() const { return _accelerateIterations; }
+
     /** Returns the symmetry dimension of the input model, including sources and media, if present.
         A value of 1 means spherical symmetry, 2 means axial symmetry and 3 means none of these
         symmetries. */
@@ -246,6 +291,11 @@ private:
     double _minWeightReduction{1e4};
     int _minScattEvents{0};
     double _pathLengthBias{0.5};
+    bool _threadPrivateRadiationField{false};
+    bool _singlePrecisionRadiationField{false};
+    bool _skipEmptySpace{false};
+    bool _truncatePaths{false};
+    bool _groupWavelengths{false};
     int _numDensitySamples{100};
 
     // radiation field
@@ -261,6 +311,9 @@ private:
     DisjointWavelengthGrid* _dustEmissionWLG{nullptr};
     SpatialCellLibrary* _cellLibrary{nullptr};
     bool _storeEmissionRadiationField{false};
+    bool _precalculateEmissionSpectra{false};
+    double _maxEmissionSpectraMemory{1.};
+    double _emissionSpectrumReuseThreshold{0.};
     double _secondarySpatialBias{0.5};
     double _secondaryWavelengthBias{0.5};
     WavelengthDistribution* _secondaryWavelengthBiasDistribution{nullptr};
@@ -268,6 +321,8 @@ private:
     int _maxIterations{10};
     double _maxFractionOfPrimary{0.01};
     double _maxFractionOfPrevious{0.03};
+    double _initialIterationPacketsFraction{1.};
+    bool _accelerateIterations{false};
 
     // properties derived from the configuration at large
     int _modelDimension{0};
@@ -165,6 +165,44 @@ namespace
 
     // maximum number of nodes subdivided between two invocations of infoIfElapsed()
     const size_t logDivideChunkSize = 5000;
+
+    // subdivides the nodes with the specified indices in the node list, in parallel, and appends the new
+    // children to the node list in the order of the specified indices; the node IDs are thus identical
+    // to those assigned when subdividing the nodes serially in that order; the neighbor lists are not updated
+    void subdivideNodes(Parallel* parallel, Log* log, int level, vector<TreeNode*>& nodev,
+                        const vector<size_t>& indices)
+    {
+        size_t numDivideNodes = indices.size();
+        if (!numDivideNodes) return;
+        log->infoSetElapsed(numDivideNodes);
+
+        // subdivide the first node to determine the number of children per node,
+        // which is the same for all nodes in the tree
+        size_t firstID = nodev.size();
+        nodev[indices[0]]->createChildren(firstID);
+        size_t numChildren = nodev[indices[0]]->children().size();
+        nodev.resize(firstID + numDivideNodes*numChildren);
+
+        // subdivide all nodes, assigning a predetermined range of IDs to the children of each node
+        parallel->call(numDivideNodes, [log, level, &nodev, &indices, firstID, numChildren]
+                       (size_t firstIndex, size_t numIndices)
+        {
+            while (numIndices)
+            {
+                size_t currentChunkSize = min(logDivideChunkSize, numIndices);
+                for (size_t i=firstIndex; i!=firstIndex+currentChunkSize; ++i)
+                {
+                    TreeNode* node = nodev[indices[i]];
+                    size_t id = firstID + i*numChildren;
+                    if (i) node->createChildren(id);
+                    for (auto child : node->children()) nodev[id++] = child;
+                }
+                log->infoIfElapsed("Subdivision for level " + std::to_string(level) + ": ", currentChunkSize);
+                firstIndex += currentChunkSize;
+                numIndices -= currentChunkSize;
+            }
+        });
+    }
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -173,6 +211,7 @@ vector<TreeNode*> DensityTreePolicy::constructTree(TreeNode* root)
 {
     auto log = find<Log>();
     auto parallel = find<ParallelFactory>()->parallelDistributed();
+    auto localParallel = find<ParallelFactory>()->parallelDuplicated();
 
     // initialize the tree node list with the root node as the first item
     vector<TreeNode*> nodev{root};
@@ -184,13 +223,10 @@ vector<TreeNode*> DensityTreePolicy::constructTree(TreeNode* root)
     while (level!=minLevel())
     {
         log->info("Subdividing level " + std::to_string(level) + ": " + std::to_string(lend-lbeg) + " nodes");
-        log->infoSetElapsed(lend-lbeg);
-        for (size_t l=lbeg; l!=lend; ++l)
-        {
-            nodev[l]->subdivide(nodev);
-            if ((l+1)%logDivideChunkSize == 0)
-                log->infoIfElapsed("Subdividing level " + std::to_string(level) + ": ", logDivideChunkSize);
-        }
+        vector<size_t> indices(lend-lbeg);
+        for (size_t l=lbeg; l!=lend; ++l) indices[l-lbeg] = l;
+        subdivideNodes(localParallel, log, level, nodev, indices);
+
         // update iteration variables to the next level
         level++;
         lbeg = lend;
@@ -207,6 +243,7 @@ vector<TreeNode*> DensityTreePolicy::constructTree(TreeNode* root)
         // evaluate nodes at this level: value in the array becomes one for nodes that need to be subdivided
         // we parallelize this operation because it might be resource intensive (e.g. sampling densities)
         Array divide(numEvalNodes);
+        _random->startSegment();
         parallel->call(numEvalNodes, [this, log, level, lbeg, &nodev, &divide](size_t firstIndex, size_t numIndices)
         {
             while (numIndices)
@@ -214,37 +251,44 @@ vector<TreeNode*> DensityTreePolicy::constructTree(TreeNode* root)
                 size_t currentChunkSize = min(logEvalChunkSize, numIndices);
                 for (size_t l=firstIndex; l!=firstIndex+currentChunkSize; ++l)
                 {
+                    _random->startHistory(lbeg+l);
                     if (needsSubdivide(nodev[lbeg+l])) divide[l] = 1.;
                 }
                 log->infoIfElapsed("Evaluation for level " + std::to_string(level) + ": ", currentChunkSize);
                 firstIndex += currentChunkSize;
                 numIndices -= currentChunkSize;
             }
+            _random->stopHistory();
         });
         ProcessManager::sumToAll(divide);
 
         // subdivide the nodes that have been flagged
-        size_t numDivideNodes = divide.sum();
-        log->infoSetElapsed(numDivideNodes);
-        size_t numDone = 0;
-        for (size_t l=0; l!=numEvalNodes; ++l)
-        {
-            if (divide[l])
-            {
-                nodev[lbeg+l]->subdivide(nodev);
-                numDone++;
-                if (numDone%logDivideChunkSize == 0)
-                    log->infoIfElapsed("Subdivision for level " + std::to_string(level) + ": ", logDivideChunkSize);
-            }
-        }
+        vector<size_t> indices;
+        for (size_t l=0; l!=numEvalNodes; ++l) if (divide[l]) indices.push_back(lbeg+l);
+        subdivideNodes(localParallel, log, level, nodev, indices);
+
         // update iteration variables to the next level
         level++;
         lbeg = lend;
         lend = nodev.size();
     }
 
-    // sort the neighbors for all nodes
-    for (auto node : nodev) node->sortNeighbors();
+    // construct and sort the neighbor lists for all leaf nodes; because each node updates just its own lists,
+    // this can be done in parallel once the tree structure is complete
+    size_t numNodes = nodev.size();
+    log->info("Constructing neighbor lists for the tree nodes");
+    localParallel->call(numNodes, [root, &nodev](size_t firstIndex, size_t numIndices)
+    {
+        for (size_t l=firstIndex; l!=firstIndex+numIndices; ++l)
+        {
+            TreeNode* node = nodev[l];
+            if (node->isChildless())
+            {
+                node->findNeighbors(root);
+                node->sortNeighbors();
+            }
+        }
+    });
     return nodev;
 }
 
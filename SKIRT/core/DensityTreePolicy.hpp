@@ -136,11 +136,17 @@ public:
         between evaluating all of the nodes (i.e. determining which nodes need subdivision) and
         actually subdividing the nodes that need it.
 
-        These operations are split over two phases because the first one can be parallelized (the
-        only output is a Boolean flag), while the second one cannot (the tree structure is updated
-        in various ways). Parallelizing the first operation is often meaningful, because
-        determining whether a node needs subdivision can be resource-intensive (for example, it may
-        require sampling densities in the source distribution). */
+        Both operations are parallelized. Determining whether a node needs subdivision can be
+        resource-intensive (for example, it may require sampling densities in the source
+        distribution), so this work is distributed over all execution threads and processes. The
+        subsequent subdivision is performed in parallel by the execution threads in each process.
+        The children of each subdivided node receive a predetermined range of node IDs, so that the
+        resulting tree is identical to the one obtained by subdividing the nodes serially.
+
+        The neighbor lists are not updated during subdivision, because the updates for adjacent
+        nodes would interfere. Instead, once the tree structure is complete, the neighbor lists for
+        all leaf nodes are constructed from scratch and sorted, again in parallel. The nonleaf nodes
+        in the returned tree do not have neighbor lists. */
     vector<TreeNode*> constructTree(TreeNode* root) override;
 
     //======================== Other Functions =======================
@@ -4,6 +4,7 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "DistantInstrument.hpp"
+#include "FluxRecorder.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
@@ -27,6 +28,9 @@ void DistantInstrument::setupSelfBefore()
     _bfky = Direction( - cosphi*costheta*cosomega - sinphi*sinomega,
                        - sinphi*costheta*cosomega + cosphi*sinomega,
                        + sintheta*cosomega );
+
+    // configure flux recorder
+    if (precomputeOpticalDepths()) instrumentFluxRecorder()->includeOpticalDepthMap(_bfkobs);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -57,8 +57,31 @@ class DistantInstrument : public Instrument
         ATTRIBUTE_DEFAULT_VALUE(roll, "0 deg")
         ATTRIBUTE_DISPLAYED_IF(roll, "Level2&(Dimension2|Dimension3)")
 
+    PROPERTY_BOOL(precomputeOpticalDepths, "precompute approximate optical depths from each spatial cell center to the instrument")
+        ATTRIBUTE_DEFAULT_VALUE(precomputeOpticalDepths, "false")
+        ATTRIBUTE_DISPLAYED_IF(precomputeOpticalDepths, "Level3")
+
     ITEM_END()
 
+    /** \fn precomputeOpticalDepths
+        If this flag is enabled, the instrument precomputes the column density of each medium
+        component along a path from the center of each spatial cell towards the instrument before
+        the photon packet life cycle starts. The optical depth for a peeled-off photon packet is
+        then obtained from the precomputed column densities for the cell containing the peel-off
+        position, avoiding the need to trace the path through the spatial grid for every emission
+        and scattering event. This can substantially reduce the run time for simulations with
+        multiple instruments.
+
+        This is an approximation: the optical depth from the peel-off position is replaced by the
+        optical depth from the center of the cell containing that position. The error does not
+        average out over many photon packets, so the recorded fluxes are biased for cells that are
+        large compared to the scale on which the media vary or that have a substantial optical
+        depth across their extent. Hence this option is appropriate only for spatial grids that
+        sufficiently resolve the media. The precomputed values require additional memory
+        proportional to the number of cells times the number of media; instruments with the same
+        viewing direction share a single copy. They are used only if the material properties of each medium are spatially constant
+        and the media have no bulk velocities; otherwise this flag is ignored. */
+
     //============= Construction - Setup - Destruction =============
 
 protected:
@@ -37,11 +37,12 @@ void DustAbsorptionPerCellProbe::probeRun()
                                + StringUtils::toString(units->owavelength(wavelengthGrid->wavelength(ell)), 'g')
                                + " " + units->uwavelength(), units->umonluminosity());
 
-            // write a line for each cell
+            // write a line for each cell, listed in the original cell numbering
             int numCells = grid->numCells();
-            for (int m=0; m!=numCells; ++m)
+            for (int n=0; n!=numCells; ++n)
             {
-                vector<double> values({ static_cast<double>(m) });
+                int m = grid->cellIndexFromOriginal(n);
+                vector<double> values({ static_cast<double>(n) });
                 const Array& Jv = ms->meanIntensity(m);
                 double factor = 4.*M_PI * ms->volume(m);
                 for (int ell=0; ell!=wavelengthGrid->numBins(); ++ell)
@@ -49,6 +49,27 @@ class DustEmissionOptions : public SimulationItem, public SourceWavelengthRangeI
         ATTRIBUTE_DEFAULT_VALUE(storeEmissionRadiationField, "false")
         ATTRIBUTE_DISPLAYED_IF(storeEmissionRadiationField, "Level3")
 
+    PROPERTY_BOOL(precalculateEmissionSpectra,
+                  "calculate the dust emission spectra for all library entries in parallel before launching")
+        ATTRIBUTE_DEFAULT_VALUE(precalculateEmissionSpectra, "false")
+        ATTRIBUTE_DISPLAYED_IF(precalculateEmissionSpectra, "Level3")
+
+    PROPERTY_DOUBLE(maxEmissionSpectraMemory,
+                    "the maximum memory size in GB for storing the precalculated dust emission spectra")
+        ATTRIBUTE_MIN_VALUE(maxEmissionSpectraMemory, "]0")
+        ATTRIBUTE_MAX_VALUE(maxEmissionSpectraMemory, "1000]")
+        ATTRIBUTE_DEFAULT_VALUE(maxEmissionSpectraMemory, "1")
+        ATTRIBUTE_RELEVANT_IF(maxEmissionSpectraMemory, "precalculateEmissionSpectra")
+        ATTRIBUTE_DISPLAYED_IF(maxEmissionSpectraMemory, "Level3")
+
+    PROPERTY_DOUBLE(emissionSpectrumReuseThreshold,
+                    "the relative radiation field change below which a precalculated emission spectrum is reused")
+        ATTRIBUTE_MIN_VALUE(emissionSpectrumReuseThreshold, "[0")
+        ATTRIBUTE_MAX_VALUE(emissionSpectrumReuseThreshold, "1]")
+        ATTRIBUTE_DEFAULT_VALUE(emissionSpectrumReuseThreshold, "0")
+        ATTRIBUTE_RELEVANT_IF(emissionSpectrumReuseThreshold, "precalculateEmissionSpectra")
+        ATTRIBUTE_DISPLAYED_IF(emissionSpectrumReuseThreshold, "Level3")
+
     PROPERTY_DOUBLE(secondaryPacketsMultiplier,
                     "the multiplier on the number of photon packets launched for secondary emission from dust")
         ATTRIBUTE_MIN_VALUE(secondaryPacketsMultiplier, "]0")
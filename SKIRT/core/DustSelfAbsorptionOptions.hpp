@@ -13,7 +13,25 @@
 /** The DustSelfAbsorptionOptions class simply offers a number of configuration options related to
     the self-consistent calculation of dust self-absorption, including the convergence criteria for
     the iteration process. These option are relevant only when both dust emission and dust
-    self-absorption are enabled for the simulation. */
+    self-absorption are enabled for the simulation.
+
+    The \em initialIterationPacketsFraction option enables an adaptive photon packet schedule. The
+    first iteration launches the specified fraction of the number of iteration photon packets,
+    and the number of packets is doubled for each subsequent iteration. Early iterations, for which
+    the change in the radiation field is much larger than the Monte Carlo noise, thus consume
+    fewer packets. As soon as the change in absorbed dust luminosity drops below twice the
+    convergence criterion, the full number of packets is used. Convergence based on this change is
+    declared only for iterations that launched the full number of packets.
+
+    The \em accelerateIterations option enables acceleration of the self-absorption iteration.
+    Once a few consecutive iterates of the secondary radiation field are available, the field is
+    extrapolated towards the fixed point of the iteration (see the
+    MediumSystem::extrapolateSecondaryRadiationField() function). This reduces the number of
+    iterations in optically thick models, where the plain iteration converges slowly, at the cost
+    of keeping an additional copy of the secondary radiation field in memory. This copy uses the
+    same precision as the radiation field tables, and it is included in the memory allocation log
+    message issued by the medium system. The field is not extrapolated after the last iteration
+    allowed by the maximum number of iterations. */
 class DustSelfAbsorptionOptions : public SimulationItem
 {
     ITEM_CONCRETE(DustSelfAbsorptionOptions, SimulationItem,
@@ -52,6 +70,18 @@ class DustSelfAbsorptionOptions : public SimulationItem
         ATTRIBUTE_DEFAULT_VALUE(iterationPacketsMultiplier, "1")
         ATTRIBUTE_DISPLAYED_IF(iterationPacketsMultiplier, "Level3")
 
+    PROPERTY_DOUBLE(initialIterationPacketsFraction,
+                    "the fraction of the iteration photon packets launched for the first self-absorption iteration")
+        ATTRIBUTE_MIN_VALUE(initialIterationPacketsFraction, "]0")
+        ATTRIBUTE_MAX_VALUE(initialIterationPacketsFraction, "1]")
+        ATTRIBUTE_DEFAULT_VALUE(initialIterationPacketsFraction, "1")
+        ATTRIBUTE_DISPLAYED_IF(initialIterationPacketsFraction, "Level3")
+
+    PROPERTY_BOOL(accelerateIterations,
+                  "extrapolate the secondary radiation field between self-absorption iterations")
+        ATTRIBUTE_DEFAULT_VALUE(accelerateIterations, "false")
+        ATTRIBUTE_DISPLAYED_IF(accelerateIterations, "Level3")
+
     ITEM_END()
 };
 
@@ -30,11 +30,13 @@ void DustTemperaturePerCellProbe::probeRun()
         file.addColumn("spatial cell index", "", 'd');
         file.addColumn("indicative dust temperature", units->utemperature(), 'g');
 
-        // write a line for each cell
-        int numCells = ms->grid()->numCells();
-        for (int m=0; m!=numCells; ++m)
+        // write a line for each cell, listed in the original cell numbering
+        auto grid = ms->grid();
+        int numCells = grid->numCells();
+        for (int n=0; n!=numCells; ++n)
         {
-            file.writeRow(m, units->otemperature(ms->indicativeDustTemperature(m)));
+            int m = grid->cellIndexFromOriginal(n);
+            file.writeRow(n, units->otemperature(ms->indicativeDustTemperature(m)));
         }
     }
 }
@@ -0,0 +1,258 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "FieldClusterCellLibrary.hpp"
+#include "Configuration.hpp"
+#include "Log.hpp"
+#include "MediumSystem.hpp"
+#include "Parallel.hpp"
+#include "ParallelFactory.hpp"
+#include "ProcessManager.hpp"
+#include "StringUtils.hpp"
+#include "Table.hpp"
+#include "WavelengthGrid.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the local radiation field in the Milky Way (Mathis et al. 1983) integrated over all wavelengths
+    const double JtotMW = 1.7623e-06;
+
+    // cells with a smaller field strength (compared to the average in the Milky Way) are not included in the mapping
+    const double minFieldStrength = 1e-6;
+
+    // mean intensities below this fraction of the maximum for the cell are clipped in the feature vector
+    const double minRelativeIntensity = 1e-3;
+
+    // the maximum number of k-means iterations
+    const int maxIterations = 50;
+
+    // the iteration stops when the fraction of cells that changes clusters drops below this value
+    const double minReassignedFraction = 1e-3;
+}
+
+////////////////////////////////////////////////////////////////////
+
+int FieldClusterCellLibrary::numEntries() const
+{
+    return _numEntries > 0 ? _numEntries : _numClusters;
+}
+
+////////////////////////////////////////////////////////////////////
+
+vector<int> FieldClusterCellLibrary::mapping(const Array& bv) const
+{
+    // get the radiation field wavelength grid, the medium system, and the parallel engine
+    auto wavelengthGrid = find<Configuration>()->radiationFieldWLG();
+    auto ms = find<MediumSystem>();
+    auto log = find<Log>();
+    auto parallel = find<ParallelFactory>()->parallelDistributed();
+    int numCells = ms->numCells();
+    int numWavelengths = wavelengthGrid->numBins();
+
+    // --------- feature vectors ---------
+
+    // calculate the feature vector for the specified cell in single precision, and return the field strength;
+    // if the field strength is negligible, the feature vector is left untouched
+    auto featureVector = [ms, wavelengthGrid, numWavelengths](int m, float* x) {
+        Array Jv = ms->meanIntensity(m);
+        double U = ( Jv * wavelengthGrid->dlambdav() ).sum() / JtotMW;
+        if (U > minFieldStrength)
+        {
+            double Jmin = minRelativeIntensity * Jv.max();
+            for (int ell=0; ell!=numWavelengths; ++ell) x[ell] = log10(max(Jv[ell], Jmin));
+        }
+        return U;
+    };
+
+    // determine the field strength and the mean of the feature vector for each cell that will be used by the
+    // caller and has a non-negligible radiation field; the field strength remains zero for cells that are not included
+    Array Uv(numCells);
+    Array keyv(numCells);
+    parallel->call(numCells, [&bv, &Uv, &keyv, &featureVector, numWavelengths](size_t firstIndex, size_t numIndices)
+    {
+        vector<float> x(numWavelengths);
+        for (size_t m=firstIndex; m!=firstIndex+numIndices; ++m)
+        {
+            if (bv[m])
+            {
+                double U = featureVector(m, x.data());
+                if (U > minFieldStrength)
+                {
+                    Uv[m] = U;
+                    for (int ell=0; ell!=numWavelengths; ++ell) keyv[m] += x[ell];
+                    keyv[m] /= numWavelengths;
+                }
+            }
+        }
+    });
+    ProcessManager::sumToAll(Uv);
+    ProcessManager::sumToAll(keyv);
+
+    // construct a list of the included cells, sorted on the mean of their feature vector
+    vector<int> mv;
+    for (int m=0; m!=numCells; ++m) if (Uv[m] > 0.) mv.push_back(m);
+    int numSelected = mv.size();
+    std::stable_sort(begin(mv), end(mv), [&keyv](int m1, int m2) { return keyv[m1] < keyv[m2]; });
+
+    // if no cells are included, there is nothing to cluster
+    vector<int> nv(numCells, -1);
+    if (!numSelected)
+    {
+        _numEntries = _numClusters;
+        return nv;
+    }
+
+    // store the feature vectors for the included cells only (indexed on i,ell); because the radiation field is
+    // available in all processes, each process calculates all feature vectors so that no communication is needed
+    vector<float> xv(static_cast<size_t>(numSelected) * numWavelengths);
+    find<ParallelFactory>()->parallelDuplicated()->call(numSelected, [&mv, &xv, &featureVector, numWavelengths]
+                                                        (size_t firstIndex, size_t numIndices)
+    {
+        for (size_t i=firstIndex; i!=firstIndex+numIndices; ++i) featureVector(mv[i], &xv[i*numWavelengths]);
+    });
+    log->info("  Feature vectors for " + std::to_string(numSelected) + " cells occupy "
+              + StringUtils::toMemSizeString(xv.size()*sizeof(float)));
+
+    // --------- clustering ---------
+
+    // initialize the cluster centers to the feature vectors of cells evenly spaced in the sorted list
+    int numClusters = min(_numClusters, numSelected);
+    Table<2> cvv;
+    cvv.resize(numClusters, numWavelengths);
+    for (int c=0; c!=numClusters; ++c)
+    {
+        size_t i = static_cast<size_t>((c+0.5) * numSelected / numClusters);
+        for (int ell=0; ell!=numWavelengths; ++ell) cvv(c,ell) = xv[i*numWavelengths+ell];
+    }
+
+    // perform the k-means iterations
+    vector<int> av(numSelected, -1);    // the cluster index for each included cell (indexed on i)
+    Array dv(numSelected);              // the squared deviation from the cluster center summed over wavelengths
+    int iteration = 0;
+    while (true)
+    {
+        iteration++;
+
+        // sort the cluster centers on the mean of their feature vector
+        vector<int> cv(numClusters);
+        Array ckeyv(numClusters);
+        for (int c=0; c!=numClusters; ++c)
+        {
+            cv[c] = c;
+            for (int ell=0; ell!=numWavelengths; ++ell) ckeyv[c] += cvv(c,ell);
+            ckeyv[c] /= numWavelengths;
+        }
+        std::stable_sort(begin(cv), end(cv), [&ckeyv](int c1, int c2) { return ckeyv[c1] < ckeyv[c2]; });
+        vector<double> sortedkeyv(numClusters);
+        for (int s=0; s!=numClusters; ++s) sortedkeyv[s] = ckeyv[cv[s]];
+
+        // assign each included cell to the nearest cluster center; the search proceeds outwards from the
+        // cluster center with the nearest mean, and stops when the difference in means guarantees
+        // that the remaining cluster centers are farther away than the nearest one found so far
+        Array newav(numSelected);
+        Array newdv(numSelected);
+        parallel->call(numSelected, [&mv, &xv, &cvv, &keyv, &cv, &sortedkeyv, &newav, &newdv,
+                                     numClusters, numWavelengths] (size_t firstIndex, size_t numIndices)
+        {
+            for (size_t i=firstIndex; i!=firstIndex+numIndices; ++i)
+            {
+                const float* x = &xv[i*numWavelengths];
+                double key = keyv[mv[i]];
+                int hi = std::lower_bound(sortedkeyv.cbegin(), sortedkeyv.cend(), key) - sortedkeyv.cbegin();
+                int lo = hi-1;
+                double best = DBL_MAX;
+                int bestc = -1;
+                while (lo >= 0 || hi < numClusters)
+                {
+                    // select the side with the nearest mean
+                    double dlo = lo >= 0 ? key - sortedkeyv[lo] : DBL_MAX;
+                    double dhi = hi < numClusters ? sortedkeyv[hi] - key : DBL_MAX;
+                    int s = dlo < dhi ? lo-- : hi++;
+                    double dkey = min(dlo, dhi);
+                    if (dkey*dkey*numWavelengths >= best) break;
+
+                    // calculate the squared deviation, aborting as soon as it exceeds the best value so far
+                    int c = cv[s];
+                    const double* cx = &cvv(c,0);
+                    double d2 = 0.;
+                    for (int ell=0; ell!=numWavelengths && d2<best; ++ell)
+                    {
+                        double diff = x[ell] - cx[ell];
+                        d2 += diff*diff;
+                    }
+                    if (d2 < best)
+                    {
+                        best = d2;
+                        bestc = c;
+                    }
+                }
+                newav[i] = bestc;
+                newdv[i] = best;
+            }
+        });
+        ProcessManager::sumToAll(newav);
+        ProcessManager::sumToAll(newdv);
+
+        // count the number of cells that changed clusters and remember the new assignments
+        int numReassigned = 0;
+        for (int i=0; i!=numSelected; ++i)
+        {
+            int c = static_cast<int>(newav[i]);
+            if (c != av[i]) numReassigned++;
+            av[i] = c;
+        }
+        dv = newdv;
+
+        // stop iterating if the assignments have (nearly) converged
+        if (numReassigned <= minReassignedFraction*numSelected || iteration == maxIterations) break;
+
+        // move each cluster center to the average feature vector of the cells assigned to it;
+        // cluster centers without any cells remain in place
+        Table<2> sumvv;
+        sumvv.resize(numClusters, numWavelengths);
+        vector<int> countv(numClusters);
+        for (int i=0; i!=numSelected; ++i)
+        {
+            int c = av[i];
+            countv[c]++;
+            const float* x = &xv[static_cast<size_t>(i)*numWavelengths];
+            for (int ell=0; ell!=numWavelengths; ++ell) sumvv(c,ell) += x[ell];
+        }
+        for (int c=0; c!=numClusters; ++c)
+            if (countv[c]) for (int ell=0; ell!=numWavelengths; ++ell) cvv(c,ell) = sumvv(c,ell) / countv[c];
+    }
+
+    // --------- mapping ---------
+
+    // map each included cell to its cluster, or to a separate entry if it deviates too much from the cluster center
+    int numEntries = numClusters;
+    double sumDeviation = 0.;
+    double maxDeviation = 0.;
+    for (int i=0; i!=numSelected; ++i)
+    {
+        double deviation = sqrt(dv[i] / numWavelengths);
+        sumDeviation += deviation;
+        maxDeviation = max(maxDeviation, deviation);
+        if (_maxSpectralDeviation > 0. && deviation > _maxSpectralDeviation) nv[mv[i]] = numEntries++;
+        else nv[mv[i]] = av[i];
+    }
+    _numEntries = numEntries;
+
+    // log clustering statistics
+    log->info("  Grouped " + std::to_string(numSelected) + " cells into " + std::to_string(numClusters)
+              + " radiation field clusters in " + std::to_string(iteration) + " iterations");
+    log->info("  Spectral deviation from cluster centers: average "
+              + StringUtils::toString(sumDeviation/numSelected, 'f', 3) + " dex, maximum "
+              + StringUtils::toString(maxDeviation, 'f', 3) + " dex");
+    if (numEntries > numClusters)
+        log->info("  Using separate library entries for " + std::to_string(numEntries-numClusters)
+                  + " cells exceeding the maximum spectral deviation");
+
+    return nv;
+}
+
+////////////////////////////////////////////////////////////////////
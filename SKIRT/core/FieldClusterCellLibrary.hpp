@@ -0,0 +1,99 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef FIELDCLUSTERCELLLIBRARY_HPP
+#define FIELDCLUSTERCELLLIBRARY_HPP
+
+#include "SpatialCellLibrary.hpp"
+
+//////////////////////////////////////////////////////////////////////
+
+/** The FieldClusterCellLibrary class provides a library scheme for grouping spatial cells based
+    on the full spectrum of the stored radiation field, using a k-means clustering algorithm.
+
+    In contrast to the other library schemes, which bin the cells according to one or two scalar
+    indicators derived from the radiation field, this library compares the complete mean intensity
+    spectra of the cells. Each cell is represented by the feature vector \f[ x_{m,\ell} =
+    \log_{10} J_{m,\ell}, \qquad \ell=0,\ldots,N_\lambda-1, \f] where \f$J_{m,\ell}\f$ is the
+    mean intensity of the radiation field in cell \f$m\f$ discretized on the radiation field
+    wavelength grid. Values below 0.1% of the maximum value for the cell are clipped, so that
+    wavelength bins that hardly contribute to the radiation field, and that are most affected by
+    Monte Carlo noise, do not dominate the comparison. Because the feature vector is logarithmic,
+    the distance between two cells reflects both the difference in the shape of their spectra and
+    the difference in their field strength, which are both relevant for the dust emission
+    spectrum. The spectral deviation between a cell and a cluster center is defined as the
+    root-mean-square difference between their feature vectors, i.e. it is expressed in dex.
+
+    The cells are grouped into a user-configurable number of clusters using Lloyd's k-means
+    algorithm. The cluster centers are initialized deterministically to the feature vectors of
+    cells evenly spaced in a list of cells sorted on the mean of their feature vector, which is a
+    proxy for the field strength. Each iteration then assigns each cell to the nearest cluster
+    center, and moves each cluster center to the average feature vector of the cells assigned to
+    it. The iteration stops when only a very small fraction of the cells changes clusters, or when
+    a maximum number of iterations has been reached. The feature vectors are stored in single
+    precision, and only for the cells included in the clustering. Each process calculates all of
+    these feature vectors from the radiation field, which is available in all processes, so that
+    they don't need to be communicated. The assignment step is performed in parallel and
+    distributed across processes. The search for the nearest cluster center is accelerated by
+    sorting the cluster centers on the mean of their feature vectors; because the root-mean-square
+    difference between two vectors is never smaller than the difference between their means, the
+    search can stop as soon as the difference in means exceeds the smallest deviation found so far.
+
+    Optionally, the user can specify a maximum spectral deviation. After the clustering has
+    completed, each cell that deviates more than this limit from the center of its cluster is given
+    its own library entry, so that its emission spectrum is calculated from its own radiation
+    field. This guarantees that the spectral error introduced by the library mechanism remains
+    below the configured limit for all cells, at the cost of additional library entries. As a
+    result, the number of library entries is known only after the mapping has been constructed.
+
+    Cells that will not be used by the caller, and cells with a radiation field strength that is
+    negligible compared to the average interstellar radiation field in the Milky Way, are not
+    included in the mapping. */
+class FieldClusterCellLibrary : public SpatialCellLibrary
+{
+    ITEM_CONCRETE(FieldClusterCellLibrary, SpatialCellLibrary,
+                  "a library scheme for grouping spatial cells by clustering their radiation field spectra")
+        ATTRIBUTE_TYPE_INSERT(FieldClusterCellLibrary, "NonIdentitySpatialCellLibrary")
+
+    PROPERTY_INT(numClusters, "the number of radiation field clusters")
+        ATTRIBUTE_MIN_VALUE(numClusters, "10")
+        ATTRIBUTE_MAX_VALUE(numClusters, "10000000")
+        ATTRIBUTE_DEFAULT_VALUE(numClusters, "1000")
+
+    PROPERTY_DOUBLE(maxSpectralDeviation,
+                    "the maximum rms deviation in dex between a cell spectrum and its cluster center, or zero")
+        ATTRIBUTE_MIN_VALUE(maxSpectralDeviation, "[0")
+        ATTRIBUTE_MAX_VALUE(maxSpectralDeviation, "10]")
+        ATTRIBUTE_DEFAULT_VALUE(maxSpectralDeviation, "0")
+
+    ITEM_END()
+
+    //======================== Other Functions =======================
+
+protected:
+    /** This function returns the number of entries in the library. In this class, the function
+        returns the number of clusters plus the number of cells that have been given their own
+        entry because they deviate too much from their cluster center. Before the mapping()
+        function has been called, the function returns the user-configured number of clusters. */
+    int numEntries() const override;
+
+    /** This function returns a vector \em nv with length \f$N_{\text{cells}}\f$ that maps each
+        cell index \f$m\f$ to the corresponding library entry index \f$n_m\f$. In this class the
+        function calculates the feature vector for each spatial cell, groups the cells using the
+        k-means clustering algorithm, and assigns a separate library entry to cells that deviate
+        more than the configured limit from their cluster center, as described in the class
+        header. */
+    vector<int> mapping(const Array& bv) const override;
+
+    //======================== Data Members ========================
+
+private:
+    // the number of library entries determined by the most recent call to mapping(), or zero
+    mutable int _numEntries{0};
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -4,12 +4,15 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "FluxRecorder.hpp"
+#include "Configuration.hpp"
 #include "FITSInOut.hpp"
+#include "InstrumentSystem.hpp"
 #include "LockFree.hpp"
 #include "Log.hpp"
 #include "MediumSystem.hpp"
 #include "PhotonPacket.hpp"
 #include "ProcessManager.hpp"
+#include "SpatialGrid.hpp"
 #include "StringUtils.hpp"
 #include "TextOutFile.hpp"
 #include "Units.hpp"
@@ -85,11 +88,39 @@ void FluxRecorder::includeSurfaceBrightness(double distance, int numPixelsX, int
 
 ////////////////////////////////////////////////////////////////////
 
+void FluxRecorder::includeOpticalDepthMap(Direction bfkobs)
+{
+    _includeOpticalDepthMap = true;
+    _bfkobs = bfkobs;
+}
+
+////////////////////////////////////////////////////////////////////
+
 void FluxRecorder::finalizeConfiguration()
 {
     // get a pointer to the medium system, if present
     _ms = _parentItem->find<MediumSystem>(false);
 
+    // get the simulation configuration
+    auto config = _parentItem->find<Configuration>();
+
+    // precompute the column densities towards the observer, if requested and applicable
+    if (_includeOpticalDepthMap && _hasMedium && _ms)
+    {
+        auto log = _parentItem->find<Log>();
+        if (config->hasMovingMedia() || config->hasVariableMedia())
+        {
+            log->warning(_parentItem->typeAndName() + " ignores the optical depth map"
+                         " because the media have bulk velocities or spatially variable material properties");
+        }
+        else
+        {
+            // the instrument system shares the map between instruments with the same viewing direction
+            _columnDensities = &_parentItem->find<InstrumentSystem>(false)->columnDensities(_bfkobs);
+            _grid = _ms->grid();
+        }
+    }
+
     // get array lengths
     _numPixelsInFrame = _numPixelsX * _numPixelsY;  // convert to size_t before calculating lenIFU
     size_t lenSED = _includeFluxDensity ? _lambdagrid->numBins() : 0;
@@ -184,7 +215,10 @@ void FluxRecorder::detect(PhotonPacket* pp, int l, double distance)
             }
             else
             {
-                tau = _ms->opticalDepth(pp, distance);
+                // use the precomputed column densities for the cell containing the packet, if available
+                int m = _grid ? _grid->cellIndex(pp->position()) : -1;
+                if (m >= 0) tau = _ms->opticalDepth(pp->wavelength(), *_columnDensities, m);
+                else tau = _ms->opticalDepth(pp, distance);
                 pp->setObservedOpticalDepth(tau);
             }
             Lext *= exp(-tau);
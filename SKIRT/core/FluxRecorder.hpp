@@ -7,11 +7,14 @@
 #define FLUXRECORDER_HPP
 
 #include "Array.hpp"
+#include "Direction.hpp"
+#include "Table.hpp"
 #include "ThreadLocalMember.hpp"
 #include <tuple>
 class MediumSystem;
 class PhotonPacket;
 class SimulationItem;
+class SpatialGrid;
 class WavelengthGrid;
 
 ////////////////////////////////////////////////////////////////////
@@ -93,6 +96,15 @@ class WavelengthGrid;
     requested. It includes a column for the wavelength plus a column for each of the individual
     photon contribution sums, for powers from zero to 4.
 
+    Upon request, the class can use a precomputed optical depth map to determine the attenuation
+    of peeled-off photon packets (see the includeOpticalDepthMap() function). This map lists the
+    optical depth from the \em center of each spatial cell towards the observer, so it replaces the
+    optical depth from the actual peel-off position by that of the center of the containing cell.
+    The resulting error does not average out; it biases the recorded fluxes in spatial cells that
+    are large compared to the scale on which the media vary or that are optically thick across
+    their extent. The map is calculated once for each viewing direction by the InstrumentSystem
+    and shared between the instruments observing from that direction.
+
     Usage
     -----
 
@@ -156,6 +168,22 @@ public:
     void includeSurfaceBrightness(double distance, int numPixelsX, int numPixelsY,
                                   double pixelSizeX, double pixelSizeY, double centerX, double centerY);
 
+    /** This function enables the use of precomputed optical depths towards a distant observer in
+        the specified direction. When the configuration is finalized, the recorder obtains the
+        column density of each medium component along a path from the center of each spatial cell
+        towards the observer from the instrument system, which calculates these column densities
+        only once for each direction. During detection, the optical depth for a photon
+        packet is then obtained from the column densities of the cell containing the packet's
+        position, rather than by tracing the path through the spatial grid.
+
+        This approximation ignores the position of the photon packet inside its cell, which biases
+        the result for cells that are large or optically thick, so it is appropriate only if the
+        spatial grid sufficiently resolves the media. Also, the
+        precomputed values are used only if the material properties of each medium are spatially
+        constant and the media have no bulk velocities; otherwise the recorder issues a warning and
+        calculates the optical depth for each detected photon packet as usual. */
+    void includeOpticalDepthMap(Direction bfkobs);
+
     /** This function completes the configuration of the recorder. It must be called after any of
         the configuration functions, and before the first invocation of the detect() function. */
     void finalizeConfiguration();
@@ -270,10 +298,17 @@ private:
     double _centerX{0};
     double _centerY{0};
 
+    // recorder configuration for precomputed optical depths, received from client during configuration
+    bool _includeOpticalDepthMap{false};
+    Direction _bfkobs;
+
     // cached info, initialized when configuration is finalized
     MediumSystem* _ms{nullptr};         // pointer to medium system, if present (used only if hasMedium is true)
     bool _recordTotalOnly{true};        // becomes false if recordComponents and hasMedium are both true
     size_t _numPixelsInFrame{0};        // number of pixels in a single IFU frame
+    const SpatialGrid* _grid{nullptr};  // pointer to spatial grid, if optical depth map is used
+    const Table<2>* _columnDensities{nullptr};  // column densities towards the observer indexed on (m,h), if used;
+                                                // the table is owned and shared by the instrument system
 
     // detector arrays that need to be calibrated, initialized when configuration is finalized
     vector<Array> _sed;
@@ -4,6 +4,9 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "InstrumentSystem.hpp"
+#include "Log.hpp"
+#include "MediumSystem.hpp"
+#include "StringUtils.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
@@ -34,3 +37,25 @@ void InstrumentSystem::write()
 }
 
 ////////////////////////////////////////////////////////////////////
+
+const Table<2>& InstrumentSystem::columnDensities(Direction bfkobs)
+{
+    // return the table for this direction if it has already been calculated
+    for (const auto& entry : _columnDensities)
+    {
+        const Direction& k = entry.first;
+        if (k.x() == bfkobs.x() && k.y() == bfkobs.y() && k.z() == bfkobs.z()) return *entry.second;
+    }
+
+    // otherwise calculate a new table and remember it
+    auto ms = find<MediumSystem>(false);
+    find<Log>()->info("Calculating optical depth map towards direction (" + StringUtils::toString(bfkobs.x()) + ", "
+                      + StringUtils::toString(bfkobs.y()) + ", " + StringUtils::toString(bfkobs.z()) + ") for "
+                      + std::to_string(ms->numCells()) + " cells...");
+    auto table = new Table<2>;
+    _columnDensities.emplace_back(bfkobs, std::unique_ptr<Table<2>>(table));
+    ms->columnDensities(bfkobs, *table);
+    return *table;
+}
+
+////////////////////////////////////////////////////////////////////
@@ -6,8 +6,11 @@
 #ifndef INSTRUMENTSYSTEM_HPP
 #define INSTRUMENTSYSTEM_HPP
 
+#include "Direction.hpp"
 #include "Instrument.hpp"
+#include "Table.hpp"
 #include "WavelengthGrid.hpp"
+#include <memory>
 
 //////////////////////////////////////////////////////////////////////
 
@@ -49,6 +52,22 @@ public:
     /** This function writes the recorded data for the complete instrument system to a set of
         files. It calls the write() function for each of the instruments. */
     void write();
+
+    /** This function returns a table with the column densities of each medium component from the
+        center of each spatial cell towards a distant observer in the specified direction, as
+        calculated by the MediumSystem::columnDensities() function. The table is calculated on the
+        first request for a given direction and retained for the lifetime of the instrument
+        system, so that instruments observing the simulated model from the same direction share a
+        single copy of the optical depth map. The function must be called only during setup, i.e.
+        not from multiple parallel execution threads, and only if the simulation has a medium
+        system. */
+    const Table<2>& columnDensities(Direction bfkobs);
+
+    //======================== Data Members ========================
+
+private:
+    // column density tables calculated by columnDensities(), each paired with its direction
+    vector<std::pair<Direction, std::unique_ptr<Table<2>>>> _columnDensities;
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -8,7 +8,6 @@
 #include "DensityInCellInterface.hpp"
 #include "DisjointWavelengthGrid.hpp"
 #include "FatalError.hpp"
-#include "LockFree.hpp"
 #include "Log.hpp"
 #include "MaterialMix.hpp"
 #include "NR.hpp"
@@ -45,38 +44,70 @@ void MediumSystem::setupSelfAfter()
 
     // initial state
     size_t allocatedBytes = 0;
-    _state1v.resize(_numCells);
-    allocatedBytes += _state1v.size()*sizeof(State1);
-    _state2vv.resize(_numCells*_numMedia);
-    allocatedBytes += _state2vv.size()*sizeof(State2);
+    _Vv.resize(_numCells);
+    allocatedBytes += _Vv.size()*sizeof(double);
+    // for oligochromatic simulations, the bulk velocity remains zero and is not stored
+    bool moving = _config->hasMovingMedia() && !_config->oligochromatic();
+    if (moving)
+    {
+        _vv.resize(_numCells);
+        allocatedBytes += _vv.size()*sizeof(Vec);
+    }
+    _nvv.resize(_numCells, _numMedia);
+    allocatedBytes += _nvv.size()*sizeof(double);
+    _mixPerCell = _config->hasVariableMedia();
+    _mixv.resize(_mixPerCell ? _numCells*_numMedia : _numMedia);
+    allocatedBytes += _mixv.size()*sizeof(const MaterialMix*);
 
     // radiation field
     if (_config->hasRadiationField())
     {
         _wavelengthGrid = _config->radiationFieldWLG();
-        _rf1.resize(_numCells, _wavelengthGrid->numBins());
-        allocatedBytes += _rf1.size()*sizeof(double);
+        bool single = _config->singlePrecisionRadiationField();
+        _rf1.resize(_numCells, _wavelengthGrid->numBins(), single);
+        allocatedBytes += _rf1.allocatedBytes();
 
         if (_config->hasSecondaryRadiationField())
         {
-            _rf2.resize(_numCells, _wavelengthGrid->numBins());
-            _rf2c.resize(_numCells, _wavelengthGrid->numBins());
-            allocatedBytes += 2*_rf2.size()*sizeof(double);
+            _rf2.resize(_numCells, _wavelengthGrid->numBins(), single);
+            _rf2c.resize(_numCells, _wavelengthGrid->numBins(), single);
+            allocatedBytes += _rf2.allocatedBytes() + _rf2c.allocatedBytes();
+
+            // previous iterate of the secondary radiation field, used only for extrapolation
+            if (_config->accelerateIterations())
+            {
+                _rf2p.resize(_numCells, _wavelengthGrid->numBins(), single);
+                allocatedBytes += _rf2p.allocatedBytes();
+            }
         }
     }
 
+    // thread-private radiation field tables, allocated by each thread upon first use
+    size_t privateBytes = 0;
+    if (_config->hasRadiationField() && _config->threadPrivateRadiationField())
+    {
+        _hasPrivateRF = true;
+        privateBytes = parfac->maxThreadCount() * (_rf1.size()+_rf2c.size()) * sizeof(double);
+        allocatedBytes += privateBytes;
+    }
+
     // inform user
-    log->info(typeAndName() + " allocated " + StringUtils::toMemSizeString(allocatedBytes) + " of memory");
+    if (!privateBytes)
+        log->info(typeAndName() + " allocated " + StringUtils::toMemSizeString(allocatedBytes) + " of memory");
+    else
+        log->info(typeAndName() + " allocated " + StringUtils::toMemSizeString(allocatedBytes) + " of memory"
+                  " (including " + StringUtils::toMemSizeString(privateBytes) + " for thread-private tables)");
 
     // ----- calculate cell densities, bulk velocities, and volumes in parallel -----
 
     log->info("Calculating densities for " + std::to_string(_numCells) + " cells...");
     auto dic = _grid->interface<DensityInCellInterface>(0, false);  // optional fast-track interface for densities
     int numSamples = _config->numDensitySamples();
-    bool oligo = _config->oligochromatic();
+    auto random = find<Random>();
+    random->startSegment();
     log->infoSetElapsed(_numCells);
     parfac->parallelDistributed()->call(_numCells,
-                                        [this, log, dic, numSamples, oligo](size_t firstIndex, size_t numIndices)
+                                        [this, log, random, dic, numSamples, moving](size_t firstIndex, size_t numIndices)
     {
         ShortArray<8> nsumv(_numMedia);
 
@@ -89,21 +120,22 @@ void MediumSystem::setupSelfAfter()
                 // density: use optional fast-track interface or sample 100 random positions within the cell
                 if (dic)
                 {
-                    for (int h=0; h!=_numMedia; ++h) state(m,h).n = dic->numberDensity(h,m);
+                    for (int h=0; h!=_numMedia; ++h) density(m,h) = dic->numberDensity(h,m);
                 }
                 else
                 {
                     nsumv.clear();
+                    random->startHistory(m);
                     for (int n=0; n<numSamples; n++)
                     {
                         Position bfr = _grid->randomPositionInCell(m);
                         for (int h=0; h!=_numMedia; ++h) nsumv[h] += _media[h]->numberDensity(bfr);
                     }
-                    for (int h=0; h!=_numMedia; ++h) state(m,h).n = nsumv[h]/numSamples;
+                    for (int h=0; h!=_numMedia; ++h) density(m,h) = nsumv[h]/numSamples;
                 }
 
-                // for oligochromatic simulations, leave bulk velocity at zero
-                if (!oligo)
+                // bulk velocity is stored only if there are kinematics in a panchromatic simulation
+                if (moving)
                 {
                     // bulk velocity: weighted average at cell center; assumes densities have been calculated
                     Position bfr = _grid->centralPositionInCell(m);
@@ -111,19 +143,20 @@ void MediumSystem::setupSelfAfter()
                     Vec v;
                     for (int h=0; h!=_numMedia; ++h)
                     {
-                        n += state(m,h).n;
-                        v += state(m,h).n * _media[h]->bulkVelocity(bfr);
+                        n += density(m,h);
+                        v += density(m,h) * _media[h]->bulkVelocity(bfr);
                     }
-                    if (n > 0.) state(m).v = v / n;  // leave bulk velocity at zero if cell has no material
+                    if (n > 0.) _vv[m] = v / n;  // leave bulk velocity at zero if cell has no material
                 }
 
                 // volume
-                state(m).V = _grid->volume(m);
+                _Vv[m] = _grid->volume(m);
             }
             log->infoIfElapsed("Calculated cell densities: ", currentChunkSize);
             firstIndex += currentChunkSize;
             numIndices -= currentChunkSize;
         }
+        random->stopHistory();
     });
 
     // communicate the calculated states across multiple processes, if needed
@@ -131,12 +164,40 @@ void MediumSystem::setupSelfAfter()
 
     log->info("Done calculating cell densities");
 
+    // ----- inform the grid about cells without material, if requested -----
+
+    if (_config->skipEmptySpace())
+    {
+        vector<char> emptyv(_numCells, 1);
+        for (int m=0; m!=_numCells; ++m)
+            for (int h=0; h!=_numMedia; ++h) if (density(m,h) > 0.) emptyv[m] = 0;
+        _grid->setEmptyCells(emptyv);
+    }
+
     // ----- obtain the material mix pointers -----
 
-    for (int m=0; m!=_numCells; ++m)
+    if (_mixPerCell)
+    {
+        for (int m=0; m!=_numCells; ++m)
+        {
+            Position bfr = _grid->centralPositionInCell(m);
+            for (int h=0; h!=_numMedia; ++h) _mixv[m*_numMedia+h] = _media[h]->mix(bfr);
+        }
+    }
+    else
+    {
+        for (int h=0; h!=_numMedia; ++h) _mixv[h] = _media[h]->mix();
+    }
+
+    // ----- precalculate the absorption cross sections at the radiation field wavelengths, if possible -----
+
+    if (_config->hasRadiationField() && !_mixPerCell)
     {
-        Position bfr = _grid->centralPositionInCell(m);
-        for (int h=0; h!=_numMedia; ++h) state(m,h).mix = _media[h]->mix(bfr);
+        int numWavelengths = _wavelengthGrid->numBins();
+        _sectionAbsvv.resize(_numMedia, numWavelengths);
+        for (int h=0; h!=_numMedia; ++h)
+            for (int ell=0; ell!=numWavelengths; ++ell)
+                _sectionAbsvv(h,ell) = cellMix(0,h)->sectionAbs(_wavelengthGrid->wavelength(ell));
     }
 }
 
@@ -146,31 +207,25 @@ void MediumSystem::communicateStates()
 {
     if (!ProcessManager::isMultiProc()) return;
 
-    // NOTE: once the design of the state data structures is stable, a custom communication procedure could be provided
-    //       in the meantime, we copy the data into a temporary table so we can use the standard sumToAll procedure
-    Table<2> data;
+    // volumes
+    ProcessManager::sumToAll(_Vv);
 
-    // volumes and bulk velocities
-    data.resize(_numCells,4);
-    for (int m=0; m!=_numCells; ++m)
+    // bulk velocities, if any; copy the data into a temporary table so we can use the standard sumToAll procedure
+    if (!_vv.empty())
     {
-        data(m,0) = state(m).V;
-        data(m,1) = state(m).v.x();
-        data(m,2) = state(m).v.y();
-        data(m,3) = state(m).v.z();
-    }
-    ProcessManager::sumToAll(data.data());
-    for (int m=0; m!=_numCells; ++m)
-    {
-        state(m).V = data(m,0);
-        state(m).v = Vec(data(m,1), data(m,3), data(m,3));
+        Table<2> data(_numCells,3);
+        for (int m=0; m!=_numCells; ++m)
+        {
+            data(m,0) = _vv[m].x();
+            data(m,1) = _vv[m].y();
+            data(m,2) = _vv[m].z();
+        }
+        ProcessManager::sumToAll(data.data());
+        for (int m=0; m!=_numCells; ++m) _vv[m] = Vec(data(m,0), data(m,1), data(m,2));
     }
 
     // densities
-    data.resize(_numCells,_numMedia);
-    for (int m=0; m!=_numCells; ++m) for (int h=0; h!=_numMedia; ++h) data(m,h) = state(m,h).n;
-    ProcessManager::sumToAll(data.data());
-    for (int m=0; m!=_numCells; ++m) for (int h=0; h!=_numMedia; ++h) state(m,h).n = data(m,h);
+    ProcessManager::sumToAll(_nvv.data());
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -207,21 +262,21 @@ int MediumSystem::numCells() const
 
 double MediumSystem::volume(int m) const
 {
-    return state(m).V;
+    return _Vv[m];
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Vec MediumSystem::bulkVelocity(int m)
 {
-    return state(m).v;
+    return cellVelocity(m);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 bool MediumSystem::hasMaterialType(MaterialMix::MaterialType type) const
 {
-    for (int h=0; h!=_numMedia; ++h) if (state(0,h).mix->materialType() == type) return true;
+    for (int h=0; h!=_numMedia; ++h) if (cellMix(0,h)->materialType() == type) return true;
     return false;
 }
 
@@ -229,28 +284,28 @@ bool MediumSystem::hasMaterialType(MaterialMix::MaterialType type) const
 
 bool MediumSystem::isMaterialType(MaterialMix::MaterialType type, int h) const
 {
-    return state(0,h).mix->materialType() == type;
+    return cellMix(0,h)->materialType() == type;
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double MediumSystem::numberDensity(int m, int h) const
 {
-    return state(m,h).n;
+    return density(m,h);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double MediumSystem::massDensity(int m, int h) const
 {
-    return state(m,h).n * state(m,h).mix->mass();
+    return density(m,h) * cellMix(m,h)->mass();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 const MaterialMix* MediumSystem::mix(int m, int h) const
 {
-    return state(m,h).mix;
+    return cellMix(m,h);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -261,17 +316,17 @@ const MaterialMix* MediumSystem::randomMixForScattering(Random* random, double l
     if (_numMedia>1)
     {
         Array Xv;
-        NR::cdf(Xv, _numMedia, [this,lambda,m](int h){ return state(m,h).n * state(m,h).mix->sectionSca(lambda); });
+        NR::cdf(Xv, _numMedia, [this,lambda,m](int h){ return density(m,h) * cellMix(m,h)->sectionSca(lambda); });
         h = NR::locateClip(Xv, random->uniform());
     }
-    return state(m,h).mix;
+    return cellMix(m,h);
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double MediumSystem::opacitySca(double lambda, int m, int h) const
 {
-    return state(m,h).n * state(m,h).mix->sectionSca(lambda);
+    return density(m,h) * cellMix(m,h)->sectionSca(lambda);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -279,7 +334,7 @@ double MediumSystem::opacitySca(double lambda, int m, int h) const
 double MediumSystem::opacitySca(double lambda, int m) const
 {
     double result = 0.;
-    for (int h=0; h!=_numMedia; ++h) result += state(m,h).n * state(m,h).mix->sectionSca(lambda);
+    for (int h=0; h!=_numMedia; ++h) result += density(m,h) * cellMix(m,h)->sectionSca(lambda);
     return result;
 }
 
@@ -289,7 +344,7 @@ double MediumSystem::opacityAbs(double lambda, int m, MaterialMix::MaterialType
 {
     double result = 0.;
     for (int h=0; h!=_numMedia; ++h)
-        if (state(0,h).mix->materialType() == type) result += state(m,h).n * state(m,h).mix->sectionAbs(lambda);
+        if (cellMix(0,h)->materialType() == type) result += density(m,h) * cellMix(m,h)->sectionAbs(lambda);
     return result;
 }
 
@@ -297,7 +352,7 @@ double MediumSystem::opacityAbs(double lambda, int m, MaterialMix::MaterialType
 
 double MediumSystem::opacityExt(double lambda, int m, int h) const
 {
-    return state(m,h).n * state(m,h).mix->sectionExt(lambda);
+    return density(m,h) * cellMix(m,h)->sectionExt(lambda);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -305,7 +360,7 @@ double MediumSystem::opacityExt(double lambda, int m, int h) const
 double MediumSystem::opacityExt(double lambda, int m) const
 {
     double result = 0.;
-    for (int h=0; h!=_numMedia; ++h) result += state(m,h).n * state(m,h).mix->sectionExt(lambda);
+    for (int h=0; h!=_numMedia; ++h) result += density(m,h) * cellMix(m,h)->sectionExt(lambda);
     return result;
 }
 
@@ -315,7 +370,7 @@ double MediumSystem::opacityExt(double lambda, int m, MaterialMix::MaterialType
 {
     double result = 0.;
     for (int h=0; h!=_numMedia; ++h)
-        if (state(0,h).mix->materialType() == type) result += state(m,h).n * state(m,h).mix->sectionExt(lambda);
+        if (cellMix(0,h)->materialType() == type) result += density(m,h) * cellMix(m,h)->sectionExt(lambda);
     return result;
 }
 
@@ -323,7 +378,7 @@ double MediumSystem::opacityExt(double lambda, int m, MaterialMix::MaterialType
 
 double MediumSystem::albedo(double lambda, int m, int h) const
 {
-    return state(m,h).mix->albedo(lambda);
+    return cellMix(m,h)->albedo(lambda);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -334,8 +389,8 @@ double MediumSystem::albedo(double lambda, int m) const
     double kext = 0.;
     for (int h=0; h!=_numMedia; ++h)
     {
-        double n = state(m,h).n;
-        auto mix = state(m,h).mix;
+        double n = density(m,h);
+        auto mix = cellMix(m,h);
         ksca += n * mix->sectionSca(lambda);
         kext += n * mix->sectionExt(lambda);
     }
@@ -346,8 +401,12 @@ double MediumSystem::albedo(double lambda, int m) const
 
 double MediumSystem::opticalDepth(SpatialGridPath* path, double lambda, MaterialMix::MaterialType type)
 {
-    // determine the geometric details of the path
+    // determine the geometric details of the path; regions without material don't contribute,
+    // so they may be skipped, but the caller's setting is restored afterwards
+    bool skip = path->skipEmptyCells();
+    path->setSkipEmptyCells(true);
     _grid->path(path);
+    path->setSkipEmptyCells(skip);
 
     // calculate the optical depth
     double tau = 0.;
@@ -362,8 +421,12 @@ double MediumSystem::opticalDepth(SpatialGridPath* path, double lambda, Material
 
 double MediumSystem::opticalDepth(PhotonPacket* pp, double distance)
 {
-    // determine the geometric details of the path
-    _grid->path(pp);
+    // determine the geometric details of the path, unless they are already known
+    if (!pp->isComplete())
+    {
+        _grid->path(pp);
+        pp->markComplete();
+    }
 
     // calculate the cumulative optical depth and store the corresponding extinction factors in the photon packet;
     // because this function is the heart of the photon life cycle, we implement optimized versions for special cases
@@ -375,11 +438,11 @@ double MediumSystem::opticalDepth(PhotonPacket* pp, double distance)
         // single medium (no kinematics, spatially constant)
         if (_numMedia==1)
         {
-            double section = state(0,0).mix->sectionExt(pp->wavelength());
+            double section = cellMix(0,0)->sectionExt(pp->wavelength());
             int i = 0;
             for (auto& segment : pp->segments())
             {
-                if (segment.m >= 0) tau += section * state(segment.m,0).n * segment.ds;
+                if (segment.m >= 0) tau += section * density(segment.m,0) * segment.ds;
                 pp->setOpticalDepth(i++, tau);
                 if (segment.s > distance) break;
             }
@@ -388,12 +451,12 @@ double MediumSystem::opticalDepth(PhotonPacket* pp, double distance)
         else
         {
             ShortArray<8> sectionv(_numMedia);
-            for (int h=0; h!=_numMedia; ++h) sectionv[h] = state(0,h).mix->sectionExt(pp->wavelength());
+            for (int h=0; h!=_numMedia; ++h) sectionv[h] = cellMix(0,h)->sectionExt(pp->wavelength());
             int i = 0;
             for (auto& segment : pp->segments())
             {
                 if (segment.m >= 0)
-                    for (int h=0; h!=_numMedia; ++h) tau += sectionv[h] * state(segment.m,h).n * segment.ds;
+                    for (int h=0; h!=_numMedia; ++h) tau += sectionv[h] * density(segment.m,h) * segment.ds;
                 pp->setOpticalDepth(i++, tau);
                 if (segment.s > distance) break;
             }
@@ -405,7 +468,7 @@ double MediumSystem::opticalDepth(PhotonPacket* pp, double distance)
         int i = 0;
         for (auto& segment : pp->segments())
         {
-            if (segment.m >= 0) tau += opacityExt(pp->perceivedWavelength(state(segment.m).v), segment.m) * segment.ds;
+            if (segment.m >= 0) tau += opacityExt(pp->perceivedWavelength(cellVelocity(segment.m)), segment.m) * segment.ds;
             pp->setOpticalDepth(i++, tau);
             if (segment.s > distance) break;
         }
@@ -416,12 +479,110 @@ double MediumSystem::opticalDepth(PhotonPacket* pp, double distance)
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // the number of segments in the first stretch of a path calculated by setInteractionPoint();
+    // the number is doubled for each subsequent stretch
+    const size_t initialStretchSegments = 16;
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool MediumSystem::setInteractionPoint(PhotonPacket* pp, double tau)
+{
+    // precalculate the extinction cross sections if there are no kinematics and material properties are constant
+    bool constant = !_config->hasMovingMedia() && !_config->hasVariableMedia();
+    ShortArray<8> sectionv(_numMedia);
+    if (constant) for (int h=0; h!=_numMedia; ++h) sectionv[h] = cellMix(0,h)->sectionExt(pp->wavelength());
+
+    // calculate the path in stretches until the optical depth is reached or the path leaves the grid
+    size_t numSegments = initialStretchSegments;
+    while (true)
+    {
+        pp->setSegmentLimit(numSegments);
+        _grid->path(pp);
+        bool truncated = pp->atSegmentLimit();
+        pp->setSegmentLimit(0);
+
+        // accumulate the optical depth along the stretch
+        double taustretch = 0.;
+        int i = 0;
+        for (auto& segment : pp->segments())
+        {
+            if (segment.m >= 0)
+            {
+                if (constant)
+                    for (int h=0; h!=_numMedia; ++h) taustretch += sectionv[h] * density(segment.m,h) * segment.ds;
+                else
+                    taustretch += opacityExt(pp->perceivedWavelength(cellVelocity(segment.m)), segment.m) * segment.ds;
+            }
+            pp->setOpticalDepth(i++, taustretch);
+        }
+
+        // if the optical depth is reached within this stretch, locate the interaction point
+        if (taustretch >= tau)
+        {
+            pp->findInteractionPoint(tau);
+            return pp->interactionCellIndex() >= 0;
+        }
+
+        // if the path has left the grid, there is no interaction point
+        if (!truncated) return false;
+
+        // otherwise, move to the end of the stretch and continue with a longer stretch
+        pp->propagate(pp->segments().back().s);
+        tau -= taustretch;
+        numSegments *= 2;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MediumSystem::columnDensities(Direction bfk, Table<2>& Nmh)
+{
+    Nmh.resize(_numCells, _numMedia);
+
+    // trace a path from the center of each cell, and accumulate the column densities along the path
+    auto parallel = find<ParallelFactory>()->parallelDistributed();
+    parallel->call(_numCells, [this, bfk, &Nmh](size_t firstIndex, size_t numIndices)
+    {
+        SpatialGridPath path;
+        path.setDirection(bfk);
+        path.setSkipEmptyCells(true);
+        for (size_t m=firstIndex; m!=firstIndex+numIndices; ++m)
+        {
+            path.setPosition(_grid->centralPositionInCell(m));
+            _grid->path(&path);
+            for (const auto& segment : path.segments())
+            {
+                if (segment.m >= 0)
+                    for (int h=0; h!=_numMedia; ++h) Nmh(m,h) += density(segment.m,h) * segment.ds;
+            }
+        }
+    });
+
+    // communicate the results across multiple processes, if needed
+    ProcessManager::sumToAll(Nmh.data());
+}
+
+////////////////////////////////////////////////////////////////////
+
+double MediumSystem::opticalDepth(double lambda, const Table<2>& Nmh, int m) const
+{
+    double tau = 0.;
+    for (int h=0; h!=_numMedia; ++h) tau += cellMix(0,h)->sectionExt(lambda) * Nmh(m,h);
+    return tau;
+}
+
+////////////////////////////////////////////////////////////////////
+
 void MediumSystem::clearRadiationField(bool primary)
 {
     if (primary)
     {
         _rf1.setToZero();
         if (_rf2.size()) _rf2.setToZero();
+        _rf2sv.clear();
     }
     else
     {
@@ -433,24 +594,151 @@ void MediumSystem::clearRadiationField(bool primary)
 
 void MediumSystem::storeRadiationField(bool primary, int m, int ell, double Lds)
 {
-    if (primary) LockFree::add(_rf1(m,ell), Lds);
-    else LockFree::add(_rf2c(m,ell), Lds);
+    if (primary) _rf1.add(m, ell, Lds);
+    else _rf2c.add(m, ell, Lds);
+}
+
+////////////////////////////////////////////////////////////////////
+
+Table<2>* MediumSystem::privateRadiationField(bool primary)
+{
+    if (!_hasPrivateRF) return nullptr;
+    Table<2>* rf = primary ? _rf1p.local() : _rf2cp.local();
+    if (!rf->size()) rf->resize(_numCells, _wavelengthGrid->numBins());
+    return rf;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void MediumSystem::mergePrivateRadiationField(bool primary)
+{
+    RadiationFieldTable& rf = primary ? _rf1 : _rf2c;
+    vector<Table<2>*> rfpv = primary ? _rf1p.all() : _rf2cp.all();
+
+    // each parallel task handles a range of cells, i.e. a contiguous range of table entries
+    find<ParallelFactory>()->parallelDuplicated()->call(_numCells,
+                                                        [&rf, &rfpv](size_t firstIndex, size_t numIndices)
+    {
+        for (Table<2>* rfp : rfpv)
+        {
+            if (rfp->size()) rf.addAndClear(*rfp, firstIndex, numIndices);
+        }
+    });
 }
 
 ////////////////////////////////////////////////////////////////////
 
 void MediumSystem::communicateRadiationField(bool primary)
 {
-    if (primary) ProcessManager::sumToAll(_rf1.data());
+    if (_hasPrivateRF) mergePrivateRadiationField(primary);
+    if (primary) _rf1.sumToAll();
     else
     {
-        ProcessManager::sumToAll(_rf2c.data());
+        _rf2c.sumToAll();
         _rf2 = _rf2c;
     }
 }
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // the minimum number of consecutive iterates needed to estimate the convergence ratio
+    const size_t minNumIterates = 4;
+
+    // the maximum factor by which the secondary radiation field is extrapolated (corresponding to
+    // a convergence ratio of 0.8), limiting the amplification of the Monte Carlo noise
+    const double maxExtrapolationFactor = 4.;
+
+    // the number of consecutive cells summed into a single partial sum when summing the radiation field over all cells
+    const size_t summationBlockSize = 1024;
+}
+
+////////////////////////////////////////////////////////////////////
+
+double MediumSystem::extrapolateSecondaryRadiationField()
+{
+    size_t numBins = _wavelengthGrid->numBins();
+
+    // returns the current iterate summed over all cells for each wavelength bin; the table is traversed
+    // in storage order, and the partial sums for fixed blocks of cells are added in a fixed order
+    // so that the result does not depend on the number of threads or processes
+    auto summedIterate = [this, numBins]()
+    {
+        size_t numBlocks = (_numCells + summationBlockSize - 1) / summationBlockSize;
+        Table<2> partialvv;
+        partialvv.resize(numBlocks, numBins);
+        find<ParallelFactory>()->parallelDistributed()->call(numBlocks, [this, &partialvv, numBins]
+                                                             (size_t firstIndex, size_t numIndices)
+        {
+            for (size_t b=firstIndex; b!=firstIndex+numIndices; ++b)
+            {
+                double* partialv = &partialvv(b,0);
+                size_t end = min((b+1)*summationBlockSize, static_cast<size_t>(_numCells));
+                for (size_t m=b*summationBlockSize; m!=end; ++m)
+                    for (size_t ell=0; ell!=numBins; ++ell) partialv[ell] += _rf2(m,ell);
+            }
+        });
+        ProcessManager::sumToAll(partialvv.data());
+
+        Array sv(numBins);
+        for (size_t b=0; b!=numBlocks; ++b)
+            for (size_t ell=0; ell!=numBins; ++ell) sv[ell] += partialvv(b,ell);
+        return sv;
+    };
+
+    // remember the summed current iterate
+    _rf2sv.push_back(summedIterate());
+
+    // estimate the convergence ratio as the least-squares ratio between consecutive differences of the summed iterates
+    double f = 0.;
+    size_t numIterates = _rf2sv.size();
+    if (numIterates >= minNumIterates)
+    {
+        double num = 0.;
+        double den = 0.;
+        for (size_t i=2; i!=numIterates; ++i)
+        {
+            Array dv = _rf2sv[i] - _rf2sv[i-1];
+            Array dpv = _rf2sv[i-1] - _rf2sv[i-2];
+            num += (dv*dpv).sum();
+            den += (dpv*dpv).sum();
+        }
+        double r = den > 0. ? num/den : 0.;
+        if (r > 0. && r < 1.) f = min(r/(1.-r), maxExtrapolationFactor);
+    }
+
+    // if the iterates converge monotonically, replace the current iterate by the extrapolated field;
+    // in all cases, remember the current (possibly extrapolated) iterate as the previous iterate for the next call;
+    // all processes calculate the same values
+    find<ParallelFactory>()->parallelDuplicated()->call(_numCells, [this, f, numBins]
+                                                        (size_t firstIndex, size_t numIndices)
+    {
+        for (size_t m=firstIndex; m!=firstIndex+numIndices; ++m)
+        {
+            for (size_t ell=0; ell!=numBins; ++ell)
+            {
+                if (f > 0.)
+                {
+                    double x = _rf2(m,ell);
+                    _rf2.set(m, ell, max(0., x + f * (x - _rf2p(m,ell))));
+                }
+                _rf2p.set(m, ell, _rf2(m,ell));
+            }
+        }
+    });
+
+    // start a new series of iterates with the extrapolated field
+    if (f > 0.)
+    {
+        _rf2sv.clear();
+        _rf2sv.push_back(summedIterate());
+    }
+    return f;
+}
+
+////////////////////////////////////////////////////////////////////
+
 double MediumSystem::radiationField(int m, int ell) const
 {
     double rf = 0.;
@@ -463,17 +751,43 @@ double MediumSystem::radiationField(int m, int ell) const
 
 double MediumSystem::totalAbsorbedLuminosity(bool primary, MaterialMix::MaterialType type) const
 {
+    const RadiationFieldTable& rf = primary ? _rf1 : _rf2;
+
+    // calculate the absorbed luminosity for each cell in parallel, and add the results in a fixed order
+    Array Labsv(_numCells);
+    find<ParallelFactory>()->parallelDistributed()->call(_numCells,
+                                                         [this, &rf, &Labsv, type](size_t firstIndex, size_t numIndices)
+    {
+        for (size_t m=firstIndex; m!=firstIndex+numIndices; ++m) Labsv[m] = absorbedLuminosity(rf, m, type);
+    });
+    ProcessManager::sumToAll(Labsv);
+    return Labsv.sum();
+}
+
+////////////////////////////////////////////////////////////////////
+
+double MediumSystem::absorbedLuminosity(const RadiationFieldTable& rf, int m, MaterialMix::MaterialType type) const
+{
+    if (!rf.size()) return 0.;
+
+    // use the precalculated cross sections if the material properties are spatially constant
     double Labs = 0.;
-    int numWavelengths = _wavelengthGrid->numBins();
-    for (int ell=0; ell!=numWavelengths; ++ell)
+    if (_sectionAbsvv.size())
     {
-        double lambda = _wavelengthGrid->wavelength(ell);
-        for (int m=0; m!=_numCells; ++m)
+        int numWavelengths = _wavelengthGrid->numBins();
+        for (int h=0; h!=_numMedia; ++h)
         {
-            double rf = primary ? _rf1(m,ell) : _rf2(m,ell);
-            Labs += opacityAbs(lambda, m, type) * rf;
+            double n = density(m,h);
+            if (n > 0. && cellMix(0,h)->materialType() == type)
+                Labs += n * rf.weightedSum(m, &_sectionAbsvv.data()[static_cast<size_t>(h)*numWavelengths]);
         }
     }
+    else
+    {
+        int numWavelengths = _wavelengthGrid->numBins();
+        for (int ell=0; ell!=numWavelengths; ++ell)
+            Labs += opacityAbs(_wavelengthGrid->wavelength(ell), m, type) * rf(m,ell);
+    }
     return Labs;
 }
 
@@ -528,13 +842,7 @@ double MediumSystem::indicativeDustTemperature(Position bfr) const
 
 double MediumSystem::absorbedLuminosity(int m, MaterialMix::MaterialType type) const
 {
-    double Labs = 0.;
-    int numWavelengths = _wavelengthGrid->numBins();
-    for (int ell=0; ell<numWavelengths; ell++)
-    {
-        Labs += opacityAbs(_wavelengthGrid->wavelength(ell), m, type) * radiationField(m,ell);
-    }
-    return Labs;
+    return absorbedLuminosity(_rf1, m, type) + absorbedLuminosity(_rf2, m, type);
 }
 
 ////////////////////////////////////////////////////////////////////
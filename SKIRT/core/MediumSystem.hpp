@@ -13,9 +13,11 @@
 #include "MaterialMix.hpp"
 #include "Medium.hpp"
 #include "PhotonPacketOptions.hpp"
+#include "RadiationFieldTable.hpp"
 #include "SimulationItem.hpp"
 #include "SpatialGrid.hpp"
 #include "Table.hpp"
+#include "ThreadLocalMember.hpp"
 class Configuration;
 class PhotonPacket;
 class Random;
@@ -41,7 +43,10 @@ class WavelengthGrid;
     The medium state includes the following information for each cell in the spatial grid: the
     number density in the cell per medium component; (a pointer to) the corresponding material mix
     for each medium component; the aggregate bulk velocity of the material in the cell; and the
-    volume of the cell.
+    volume of the cell. Each of these items is stored in a separate array. The material mix
+    pointers are stored per cell only if at least one medium has a spatially variable material
+    mix, and the bulk velocities are stored only if at least one medium has a nonzero velocity,
+    which substantially reduces memory usage for large spatial grids.
 
     The contribution to the radation field for each spatial cell and for each wavelength in the
     simulation's radiation field wavelength grid is traced separately for primary and secondary
@@ -225,7 +230,10 @@ public:
         SpatialGridPath object.
 
         The function first calls the SpatialGrid::path() function to store the geometrical
-        information on the path through the spatial grid into the SpatialGridPath object. It then
+        information on the path through the spatial grid into the SpatialGridPath object. Because
+        regions without material do not contribute to the optical depth, the path is calculated
+        with the SpatialGridPath::skipEmptyCells() flag enabled; the flag is restored to its
+        original value before the function returns. It then
         calculates the optical depth along the path as \f[
         \tau_\text{path}(\lambda,{\boldsymbol{r}},{\boldsymbol{k}}) = \sum_m (\Delta s)_m \sum_h
         \varsigma_{\lambda}^{\text{ext}}\, n_m, \f] where \f$\varsigma_{\lambda}^{\text{abs}}\f$ is
@@ -264,9 +272,60 @@ public:
         specified distance along the path. More precisely, all path segments with an entry boundary
         at a cumulative distance along the path smaller than the specified distance are included in
         the calculation, and any remaining segments are skipped. Note that the function also does
-        not store optical depth information in the photon packet for skipped path segments. */
+        not store optical depth information in the photon packet for skipped path segments.
+
+        If the photon packet's path has been marked as complete (because it was calculated by an
+        earlier invocation of this function for the same position and direction, or because it was
+        copied from a photon packet with the same geometry), the geometric details of the path are
+        reused rather than being recalculated by the spatial grid. */
     double opticalDepth(PhotonPacket* pp, double distance=std::numeric_limits<double>::infinity());
 
+    /** This function determines the interaction point along the path of the specified photon
+        packet corresponding to the specified optical depth \f$\tau\f$, calculating the path only
+        as far as needed to reach that point. It returns true if the interaction point was found,
+        in which case it has been stored in the photon packet object (see the
+        SpatialGridPath::interactionCellIndex() and SpatialGridPath::interactionDistance()
+        functions), or false if the photon packet leaves the spatial grid before the specified
+        optical depth has been reached.
+
+        The function calculates the path in stretches with an increasing number of segments (see
+        the SpatialGridPath::setSegmentLimit() function). After each stretch, it accumulates the
+        optical depth along the new segments, calculated as described for the
+        opticalDepth(PhotonPacket*, double) function. If the specified optical depth has not yet
+        been reached and the path has not yet left the grid, the initial position of the photon
+        packet is advanced to the end of the stretch and the next stretch is calculated from
+        there. As a result, upon return, the initial position of the photon packet may have been
+        moved along its path, and the interaction distance is measured from this new position.
+        Spatial grids that do not honor the segment limit calculate the complete path in the first
+        stretch, so that the function still produces the correct result.
+
+        Because the function does not calculate the total optical depth along the path, the
+        geometric and optical depth information stored in the photon packet is not suitable for
+        recording the radiation field. */
+    bool setInteractionPoint(PhotonPacket* pp, double tau);
+
+    /** This function calculates, for each spatial cell \f$m\f$ and for each medium component
+        \f$h\f$, the column density \f[ N_{m,h} = \sum_{m'} (\Delta s)_{m'}\, n_{m',h} \f] along a
+        path that starts at the central position of the cell and heads in the specified direction
+        until it leaves the spatial grid. The results are stored in the specified table, which is
+        resized to the number of cells (first index) and the number of media (second index) as
+        needed. The calculation is parallelized and the results are synchronized across processes.
+
+        The column densities can be passed to the opticalDepth(double, const Table<2>&, int)
+        function to obtain the optical depth from a given cell towards a distant observer in the
+        specified direction without tracing the path through the spatial grid. */
+    void columnDensities(Direction bfk, Table<2>& Nmh);
+
+    /** This function returns the optical depth at wavelength \f$\lambda\f$ corresponding to the
+        column densities for cell index \f$m\f$ in the specified table, as calculated by the
+        columnDensities() function. Specifically, the function returns \f[ \tau = \sum_h
+        \varsigma_{\lambda,h}^{\text{ext}}\, N_{m,h}, \f] where
+        \f$\varsigma_{\lambda,h}^{\text{ext}}\f$ is the extinction cross section corresponding to
+        the \f$h\f$'th medium component. This is meaningful only if the material properties of
+        each medium are spatially constant and the media have no bulk velocities, i.e. if both
+        Configuration::hasVariableMedia() and Configuration::hasMovingMedia() return false. */
+    double opticalDepth(double lambda, const Table<2>& Nmh, int m) const;
+
     /** This function initializes all values of the primary and/or secondary radiation field info
         tables to zero. In simulation modes that record the radiation field, the function should be
         called before starting a simulation segment (i.e. before a set of photon packets is
@@ -288,19 +347,62 @@ public:
         are out of range, undefined behavior results. */
     void storeRadiationField(bool primary, int m, int ell, double Lds);
 
+    /** If the radiation field is accumulated in thread-private tables (see
+        Configuration::threadPrivateRadiationField()), this function returns a pointer to the
+        private primary or secondary radiation field table for the calling thread, allocating it
+        upon first use. Clients may add values of \f$L\,\Delta s\f$ to the table entries
+        (indexed on \f$m\f$ and \f$\ell\f$) without any synchronization. The contents of the
+        private tables is merged into the shared table by the communicateRadiationField()
+        function. If the radiation field is accumulated in a shared table, the function returns
+        the null pointer and clients should call the storeRadiationField() function instead. */
+    Table<2>* privateRadiationField(bool primary);
+
     /** This function accumulates the radiation field between multiple processes. In simulation
         modes that record the radiation field, the function should be called in serial code after
         finishing a simulation segment (i.e. after a before set of photon packets has been
         launched) and before querying the radiation field's contents. If the \em primary flag is
         true, the primary table is synchronized; otherwise the temporary secondary table is
-        synchronized and its contents is copied into the stable secondary table. */
+        synchronized and its contents is copied into the stable secondary table. If the radiation
+        field is accumulated in thread-private tables, the function first merges the contents of
+        these tables into the corresponding shared table and clears them. */
     void communicateRadiationField(bool primary);
 
+    /** This function accelerates the convergence of the dust self-absorption iteration by
+        extrapolating the stable secondary radiation field towards the fixed point of the
+        iteration. It should be called in serial code after each self-absorption iteration, i.e.
+        after the communicateRadiationField() function has been called for the secondary radiation
+        field.
+
+        Each self-absorption iteration applies a mapping \f$x_{n+1} = F(x_n)\f$ to the secondary
+        radiation field \f$x\f$, i.e. the table with an entry for each cell and wavelength bin.
+        For a sequence of iterates that converges geometrically with ratio \f$r\f$, the limit of
+        the sequence is given by \f[ x^* = x_n + f\,(x_n - x_{n-1}), \qquad f = \frac{r}{1-r}.
+        \f] This is the first-order form of the acceleration method of Ng (1974, J. Chem. Phys.,
+        61, 2680), which is known as Lyusternik extrapolation in the context of source iteration.
+        Ng's method estimates \f$r\f$ from the inner products of the differences \f$\delta_n =
+        x_n - x_{n-1}\f$ between the last three iterates. In a Monte Carlo simulation, however, the
+        differences between iterates for individual table entries are dominated by noise, which
+        biases such an estimate towards negative values. Therefore, this function estimates the
+        ratio as \f[ r = \frac{\sum_i \langle s_i-s_{i-1}, s_{i-1}-s_{i-2} \rangle} {\sum_i
+        \langle s_{i-1}-s_{i-2}, s_{i-1}-s_{i-2} \rangle}, \f] where \f$s_i\f$ is iterate
+        \f$x_i\f$ summed over all cells for each wavelength bin, and where the sums run over all
+        iterates since the most recent extrapolation. The extrapolation is performed once at
+        least four iterates are available and only if the iterates converge monotonically, i.e.
+        if \f$0<r<1\f$. The factor \f$f\f$ is limited to avoid excessive amplification of the
+        Monte Carlo noise in \f$x_n - x_{n-1}\f$, and negative extrapolated values are set to
+        zero. The extrapolated field then serves as the first iterate of a new series.
+
+        The function returns the extrapolation factor \f$f\f$ if the extrapolation was performed,
+        and zero otherwise. Clearing the primary radiation field (see clearRadiationField()) resets
+        the series of iterates. */
+    double extrapolateSecondaryRadiationField();
+
     /** This function returns the bolometric luminosity absorbed by media with the specified
         material type across the complete domain of the spatial grid, using the partial radiation
         field stored in the table indicated by the \em primary flag (true for the primary table,
         false for the stable secondary table). The bolometric absorbed luminosity in each cell is
-        calculated as described for the absorbedLuminosity() function. */
+        calculated as described for the absorbedLuminosity() function. The calculation is
+        parallelized over the spatial cells. The function must be called from all processes. */
     double totalAbsorbedLuminosity(bool primary, MaterialMix::MaterialType type) const;
 
 private:
@@ -381,40 +483,43 @@ public:
     //================== Private Types and Functions ====================
 
 private:
-    /** This data structure holds the information maintained per cell. */
-    struct State1
-    {
-        double V;                   // volume
-        Vec v;                      // bulk velocity
-    };
-
-    /** This data structure holds the information maintained per cell and per medium. */
-    struct State2
-    {
-        double n;                   // the number density
-        const MaterialMix* mix;     // pointer to the material mix
-    };
-
-    /** This function returns a writable reference to the state data structure for the given cell
-        index. */
-    State1& state(int m) { return _state1v[m]; }
-
-    /** This function returns a read-only reference to the state data structure for the given cell
-        index. */
-    const State1& state(int m) const { return _state1v[m]; }
-
-    /** This function returns a writable reference to the state data structure for the given cell
-        and medium indices. */
-    State2& state(int m, int h) { return _state2vv[m*_numMedia+h]; }
-
-    /** This function returns a read-only reference to the state data structure for the given cell
-        and medium indices. */
-    const State2& state(int m, int h) const { return _state2vv[m*_numMedia+h]; }
+    /** This function returns the material mix for the given cell and medium indices. If none of
+        the media has a spatially variable material mix, a single pointer is stored for each
+        medium; otherwise a pointer is stored for each cell and each medium. */
+    const MaterialMix* cellMix(int m, int h) const { return _mixPerCell ? _mixv[m*_numMedia+h] : _mixv[h]; }
+
+    /** This function returns the aggregate bulk velocity for the given cell index. The bulk
+        velocities are stored only if at least one of the media has a nonzero velocity and the
+        simulation is panchromatic; otherwise the function returns a zero velocity. */
+    Vec cellVelocity(int m) const { return _vv.empty() ? Vec() : _vv[m]; }
+
+    /** This function returns a writable reference to the number density for the given cell and
+        medium indices. The number densities are stored in a compact table separately from the
+        other state information, with the values for all media in a given cell next to each other,
+        so that the loops over the cells crossed by a path gather the densities with a minimum
+        number of cache lines. */
+    double& density(int m, int h) { return _nvv(m,h); }
+
+    /** This function returns the number density for the given cell and medium indices. */
+    double density(int m, int h) const { return _nvv(m,h); }
+
+    /** This function returns the bolometric luminosity absorbed by media of the specified type in
+        the spatial cell with index \f$m\f$, using the partial radiation field stored in the
+        specified table, or zero if the table has not been allocated. If the material properties
+        are spatially constant, the function uses absorption cross sections precalculated for each
+        medium at the radiation field wavelengths, reducing the calculation for each medium to a
+        single weighted sum over a contiguous row of the table. */
+    double absorbedLuminosity(const RadiationFieldTable& rf, int m, MaterialMix::MaterialType type) const;
 
     /** This function communicates the cell states between multiple processes after the states have
         been initialized in parallel (i.e. each process initialized a subset of the states). */
     void communicateStates();
 
+    /** This function adds the contents of the thread-private primary or secondary radiation field
+        tables for all threads to the corresponding shared table, and clears the private tables.
+        The operation is parallelized over the spatial cells. */
+    void mergePrivateRadiationField(bool primary);
+
     //======================== Data Members ========================
 
 private:
@@ -423,8 +528,12 @@ private:
     // relevant for any simulation mode that includes a medium
     int _numCells{0};           // index m
     int _numMedia{0};           // index h
-    vector<State1> _state1v;    // state info for each cell (indexed on m)
-    vector<State2> _state2vv;   // state info for each cell and each medium (indexed on m,h)
+    Array _Vv;                  // volume for each cell (indexed on m)
+    vector<Vec> _vv;            // bulk velocity for each cell (indexed on m), or empty if there are no kinematics
+    Table<2> _nvv;              // number density for each cell and each medium (indexed on m,h)
+    vector<const MaterialMix*> _mixv; // material mix for each medium (indexed on h) or for each cell and
+                                      // each medium (indexed on m,h), depending on the value of _mixPerCell
+    bool _mixPerCell{false};    // true if the material mix is stored for each cell
 
     // relevant for any simulation mode that stores the radiation field
     WavelengthGrid* _wavelengthGrid{0};  // index ell
@@ -432,9 +541,22 @@ private:
     // - the sum of rf1 and rf2 represents the stable radiation field to be used as input for regular calculations
     // - rf2c serves as a target for storing the secondary radiation field so that rf1+rf2 remain available for
     //   calculating secondary emission spectra while already shooting photons through the grid
-    Table<2> _rf1;  // radiation field from primary sources
-    Table<2> _rf2;  // radiation field from secondary sources (copied from _rf2c at the appropriate time)
-    Table<2> _rf2c; // radiation field currently being accumulated from secondary sources
+    RadiationFieldTable _rf1;  // radiation field from primary sources
+    RadiationFieldTable _rf2;  // radiation field from secondary sources (copied from _rf2c at the appropriate time)
+    RadiationFieldTable _rf2c; // radiation field currently being accumulated from secondary sources
+
+    // relevant only if the secondary radiation field is extrapolated between self-absorption iterations
+    vector<Array> _rf2sv;       // the iterates of rf2 since the last extrapolation, summed over all cells (indexed on ell)
+    RadiationFieldTable _rf2p;  // the previous iterate of rf2, allocated only if extrapolation is enabled
+
+    // absorption cross section for each medium at each radiation field wavelength (indexed on h,ell),
+    // or empty if the material properties are spatially variable
+    Table<2> _sectionAbsvv;
+
+    // relevant only if the radiation field is accumulated in thread-private tables
+    bool _hasPrivateRF{false};
+    ThreadLocalMember<Table<2>> _rf1p;  // thread-private counterpart of rf1
+    ThreadLocalMember<Table<2>> _rf2cp; // thread-private counterpart of rf2c
 };
 
 ////////////////////////////////////////////////////////////////
@@ -115,6 +115,7 @@ void MonteCarloSimulation::runPrimaryEmission()
     else
     {
         initProgress(segment, Npp);
+        random()->startSegment();
         sourceSystem()->prepareForLaunch(Npp);
         auto parallel = find<ParallelFactory>()->parallelDistributed();
         parallel->call(Npp, [this](size_t i ,size_t n)
@@ -149,6 +150,10 @@ void MonteCarloSimulation::runDustSelfAbsorptionPhase()
     int maxIters = _config->maxIterations();
     double fractionOfPrimary = _config->maxFractionOfPrimary();
     double fractionOfPrevious = _config->maxFractionOfPrevious();
+    bool accelerate = _config->accelerateIterations();
+
+    // initialize the fraction of the photon packets launched in the current iteration
+    double packetsFraction = _config->initialIterationPacketsFraction();
 
     // initialize the total absorbed luminosity in the previous iteration
     double prevLabsdust = 0.;
@@ -158,6 +163,7 @@ void MonteCarloSimulation::runDustSelfAbsorptionPhase()
     for (int iter = 1; iter<=maxIters; iter++)
     {
         string segment = "dust self-absorption iteration " + std::to_string(iter);
+        size_t Np = max(static_cast<size_t>(1), static_cast<size_t>(packetsFraction * Npp));
         {
             TimeLogger logger(log(), segment);
 
@@ -165,15 +171,16 @@ void MonteCarloSimulation::runDustSelfAbsorptionPhase()
             mediumSystem()->clearRadiationField(false);
 
             // prepare the source system; terminate if the dust has zero luminosity (which should never happen)
-            if (!_secondarySourceSystem->prepareForLaunch(Npp))
+            if (!_secondarySourceSystem->prepareForLaunch(Np))
             {
                 log()->warning("Terminating dust self-absorption phase because the total dust luminosity is zero");
                 return;
             }
 
             // launch photon packets
-            initProgress(segment, Npp);
-            parallel->call(Npp, [this](size_t i ,size_t n) { performLifeCycle(i, n, false, false, true); });
+            initProgress(segment, Np);
+            random()->startSegment();
+            parallel->call(Np, [this](size_t i ,size_t n) { performLifeCycle(i, n, false, false, true); });
             instrumentSystem()->flush();
 
             // wait for all processes to finish and synchronize the radiation field
@@ -191,6 +198,9 @@ void MonteCarloSimulation::runDustSelfAbsorptionPhase()
                    + StringUtils::toString(units()->obolluminosity(Labsdust), 'g') + " "
                    + units()->ubolluminosity() );
 
+        // determine the relative change in absorbed dust luminosity compared to the previous iteration
+        double change = Labsdust > 0. ? abs((Labsdust-prevLabsdust)/Labsdust) : 0.;
+
         // log the current performance and corresponding convergence criteria
         if (Labsprim > 0. && Labsdust > 0.)
         {
@@ -204,7 +214,7 @@ void MonteCarloSimulation::runDustSelfAbsorptionPhase()
             else
             {
                 log()->info("--> absorbed dust luminosity changed by "
-                            + StringUtils::toString(abs((Labsdust-prevLabsdust)/Labsdust)*100., 'f', 2)
+                            + StringUtils::toString(change*100., 'f', 2)
                             + "% compared to previous iteration (convergence criterion is "
                             + StringUtils::toString(fractionOfPrevious*100., 'f', 2) + "%)");
             }
@@ -215,6 +225,12 @@ void MonteCarloSimulation::runDustSelfAbsorptionPhase()
         {
             log()->info("Continuing until " + std::to_string(minIters) + " iterations have been performed");
         }
+        // do not judge convergence on the change in absorbed luminosity for iterations with fewer packets
+        else if (Np < Npp && Labsprim > 0. && Labsdust > 0. && Labsdust/Labsprim >= fractionOfPrimary)
+        {
+            log()->info("Continuing because iteration " + std::to_string(iter)
+                        + " launched a reduced number of photon packets");
+        }
         else
         {
             // the self-absorption iteration has reached convergence if one or more of the following conditions holds:
@@ -224,7 +240,7 @@ void MonteCarloSimulation::runDustSelfAbsorptionPhase()
             // - the absorbed dust luminosity has changed by less than a given fraction compared to the previous iter
             if (Labsprim <= 0. || Labsdust <= 0.
                 || Labsdust/Labsprim < fractionOfPrimary
-                || abs((Labsdust-prevLabsdust)/Labsdust) < fractionOfPrevious)
+                || change < fractionOfPrevious)
             {
                 log()->info("Convergence reached after " + std::to_string(iter) + " iterations");
                 return; // end the iteration by returning from the function
@@ -235,6 +251,29 @@ void MonteCarloSimulation::runDustSelfAbsorptionPhase()
             }
         }
         prevLabsdust = Labsdust;
+
+        // double the number of photon packets for the next iteration, or use the full number as soon as
+        // the iteration approaches convergence
+        if (packetsFraction < 1.)
+        {
+            packetsFraction = (iter > 1 && change < 2.*fractionOfPrevious) ? 1. : min(1., 2.*packetsFraction);
+        }
+
+        // extrapolate the secondary radiation field if so requested, and remember the absorbed luminosity
+        // for the extrapolated field so that the next iteration is compared to its actual input;
+        // do not extrapolate after the last iteration because there is no iteration left to verify the result
+        if (accelerate && iter < maxIters)
+        {
+            double f = mediumSystem()->extrapolateSecondaryRadiationField();
+            if (f > 0.)
+            {
+                prevLabsdust = mediumSystem()->totalAbsorbedLuminosity(false, MaterialMix::MaterialType::Dust);
+                log()->info("Extrapolated the secondary radiation field with factor "
+                            + StringUtils::toString(f, 'f', 2) + "; the total dust-absorbed dust luminosity is now "
+                            + StringUtils::toString(units()->obolluminosity(prevLabsdust), 'g') + " "
+                            + units()->ubolluminosity());
+            }
+        }
     }
 
     // if the loop runs out, convergence was not reached even after the maximum number of iterations
@@ -264,6 +303,7 @@ void MonteCarloSimulation::runSecondaryEmission()
     else
     {
         initProgress(segment, Npp);
+        random()->startSegment();
         auto parallel = find<ParallelFactory>()->parallelDistributed();
         parallel->call(Npp, [this, storeRF](size_t i, size_t n) { performLifeCycle(i, n, false, true, storeRF); });
         instrumentSystem()->flush();
@@ -316,7 +356,17 @@ namespace
 
 void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices, bool primary, bool peel, bool store)
 {
-    PhotonPacket pp,ppp;
+    // in oligochromatic simulations, each primary emission event may launch a group of photon packets,
+    // one for each wavelength; otherwise each group consists of a single photon packet
+    int groupSize = primary && _config->groupWavelengths() ? _config->wavelengthGrid(nullptr)->numBins() : 1;
+    vector<PhotonPacket> ppv(groupSize), pppv(groupSize);
+
+    // paths may skip regions without material unless the radiation field must be stored along them
+    for (auto& pp : ppv) pp.setSkipEmptyCells(!store);
+    for (auto& ppp : pppv) ppp.setSkipEmptyCells(true);
+
+    // paths may be truncated at the interaction point unless the radiation field must be stored along them
+    bool truncate = _config->truncatePaths() && !store;
 
     // loop over the history indices, with interruptions for progress logging
     while (numIndices)
@@ -324,25 +374,54 @@ void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices
         size_t currentChunkSize = min(logProgressChunkSize, numIndices);
         for (size_t historyIndex=firstIndex; historyIndex!=firstIndex+currentChunkSize; ++historyIndex)
         {
-            // launch a photon packet from the requested source
-            if (primary) sourceSystem()->launch(&pp, historyIndex);
-            else _secondarySourceSystem->launch(&pp, historyIndex);
-            if (pp.luminosity()>0)
+            // use the random stream for this history, if so requested by the user
+            random()->startHistory(historyIndex);
+
+            // launch a photon packet (or a group of photon packets) from the requested source
+            int numPackets = 1;
+            if (groupSize > 1) numPackets = sourceSystem()->launchWavelengthGroup(ppv, historyIndex);
+            else if (primary) sourceSystem()->launch(&ppv[0], historyIndex);
+            else _secondarySourceSystem->launch(&ppv[0], historyIndex);
+
+            if (peel) peelOffEmission(ppv, numPackets, pppv);
+
+            // trace the packets through the media, if any
+            if (_config->hasMedium())
             {
-                if (peel) peelOffEmission(&pp, &ppp);
+                // calculate the geometric details of the initial path just once for all packets in the group
+                if (numPackets > 1 && !truncate)
+                {
+                    const PhotonPacket* leader = nullptr;
+                    for (int k=0; k!=numPackets; ++k)
+                    {
+                        if (ppv[k].luminosity()<=0) continue;
+                        if (leader) ppv[k].copyPath(leader);
+                        else
+                        {
+                            mediumSystem()->opticalDepth(&ppv[k]);
+                            leader = &ppv[k];
+                        }
+                    }
+                }
 
-                // trace the packet through the media, if any
-                if (_config->hasMedium())
+                for (int k=0; k!=numPackets; ++k)
                 {
+                    PhotonPacket& pp = ppv[k];
+                    if (pp.luminosity()<=0) continue;
+
                     double Lthreshold = pp.luminosity() / _config->minWeightReduction();
                     int minScattEvents = _config->minScattEvents();
                     while (true)
                     {
-                        mediumSystem()->opticalDepth(&pp);
-                        if (store) storeRadiationField(&pp);
-                        simulatePropagation(&pp);
+                        if (truncate) simulateTruncatedPropagation(&pp);
+                        else
+                        {
+                            mediumSystem()->opticalDepth(&pp);
+                            if (store) storeRadiationField(&pp);
+                            simulatePropagation(&pp);
+                        }
                         if (pp.luminosity()<=0 || (pp.luminosity()<=Lthreshold && pp.numScatt()>=minScattEvents)) break;
-                        if (peel) peelOffScattering(&pp,&ppp);
+                        if (peel) peelOffScattering(&pp,&pppv[0]);
                         simulateScattering(&pp);
                     }
                 }
@@ -354,6 +433,7 @@ void MonteCarloSimulation::performLifeCycle(size_t firstIndex, size_t numIndices
         firstIndex += currentChunkSize;
         numIndices -= currentChunkSize;
     }
+    random()->stopHistory();
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -370,6 +450,29 @@ void MonteCarloSimulation::peelOffEmission(const PhotonPacket* pp, PhotonPacket*
 
 ////////////////////////////////////////////////////////////////////
 
+void MonteCarloSimulation::peelOffEmission(const vector<PhotonPacket>& ppv, int numPackets,
+                                           vector<PhotonPacket>& pppv)
+{
+    for (Instrument* instrument : _instrumentSystem->instruments())
+    {
+        bool sameObserver = instrument->isSameObserverAsPreceding();
+        const PhotonPacket* leader = nullptr;
+        for (int k=0; k!=numPackets; ++k)
+        {
+            if (ppv[k].luminosity()<=0) continue;
+            if (!sameObserver)
+            {
+                pppv[k].launchEmissionPeelOff(&ppv[k], instrument->bfkobs(ppv[k].position()));
+                if (leader) pppv[k].copyPath(leader);
+            }
+            instrument->detect(&pppv[k]);
+            if (!leader) leader = &pppv[k];
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 void MonteCarloSimulation::storeRadiationField(const PhotonPacket* pp)
 {
     // use a faster version in case there are no kinematics
@@ -380,6 +483,7 @@ void MonteCarloSimulation::storeRadiationField(const PhotonPacket* pp)
         {
             double luminosity = pp->luminosity();
             bool hasPrimaryOrigin = pp->hasPrimaryOrigin();
+            Table<2>* rf = mediumSystem()->privateRadiationField(hasPrimaryOrigin);
 
             double lnExtBeg = 0.;                 // extinction factor and its logarithm at begin of current segment
             double extBeg = 1.;
@@ -393,7 +497,8 @@ void MonteCarloSimulation::storeRadiationField(const PhotonPacket* pp)
                     // use this flavor of the lnmean function to avoid recalculating the logarithm of the extinction
                     double extMean = SpecialFunctions::lnmean(extEnd, extBeg, lnExtEnd, lnExtBeg);
                     double Lds = luminosity * extMean * segment.ds;
-                    mediumSystem()->storeRadiationField(hasPrimaryOrigin, m, ell, Lds);
+                    if (rf) (*rf)(m,ell) += Lds;
+                    else mediumSystem()->storeRadiationField(hasPrimaryOrigin, m, ell, Lds);
                 }
                 lnExtBeg = lnExtEnd;
                 extBeg = extEnd;
@@ -402,6 +507,7 @@ void MonteCarloSimulation::storeRadiationField(const PhotonPacket* pp)
     }
     else
     {
+        Table<2>* rf = mediumSystem()->privateRadiationField(pp->hasPrimaryOrigin());
         double lnExtBeg = 0.;                 // extinction factor and its logarithm at begin of current segment
         double extBeg = 1.;
         for (const auto& segment : pp->segments())
@@ -418,7 +524,8 @@ void MonteCarloSimulation::storeRadiationField(const PhotonPacket* pp)
                     // use this flavor of the lnmean function to avoid recalculating the logarithm of the extinction
                     double extMean = SpecialFunctions::lnmean(extEnd, extBeg, lnExtEnd, lnExtBeg);
                     double Lds = pp->perceivedLuminosity(lambda) * extMean * segment.ds;
-                    mediumSystem()->storeRadiationField(pp->hasPrimaryOrigin(), m, ell, Lds);
+                    if (rf) (*rf)(m,ell) += Lds;
+                    else mediumSystem()->storeRadiationField(pp->hasPrimaryOrigin(), m, ell, Lds);
                 }
             }
             lnExtBeg = lnExtEnd;
@@ -484,6 +591,41 @@ void MonteCarloSimulation::simulatePropagation(PhotonPacket* pp)
 
 ////////////////////////////////////////////////////////////////////
 
+void MonteCarloSimulation::simulateTruncatedPropagation(PhotonPacket* pp)
+{
+    // generate a random optical depth from the untruncated exponential distribution
+    double tau = random()->expon();
+
+    // determine the interaction point; if the photon packet escapes before reaching it, terminate the packet
+    if (!mediumSystem()->setInteractionPoint(pp, tau))
+    {
+        pp->applyBias(0.);
+        return;
+    }
+    int m = pp->interactionCellIndex();
+
+    // calculate the albedo for the cell containing the interaction point
+    // use a faster version in case there are no kinematics
+    double albedo;
+    if (!_config->hasMovingMedia())
+    {
+        albedo = mediumSystem()->albedo(pp->wavelength(), m);
+    }
+    else
+    {
+        Vec bfv = mediumSystem()->bulkVelocity(m);
+        albedo = mediumSystem()->albedo(pp->perceivedWavelength(bfv), m);
+    }
+
+    // adjust the weight by the albedo; the escaped fraction is accounted for by terminating escaping packets
+    pp->applyBias(albedo);
+
+    // advance the position
+    pp->propagate(pp->interactionDistance());
+}
+
+////////////////////////////////////////////////////////////////////
+
 namespace
 {
     // This helper function returns the angle phi between the previous and current scattering planes
@@ -186,7 +186,16 @@ private:
         criteria which can also be specified as configuration options. Convergence is reached (and
         the function exits) when (a) the absorbed dust luminosity is less than a given fraction of
         the absorbed stellar luminosity, \em OR (b) the absorbed dust luminosity has changed by
-        less than a given fraction compared to the previous iteration. */
+        less than a given fraction compared to the previous iteration.
+
+        If so requested by the configuration, the early iterations launch a reduced number of
+        photon packets, which is doubled in each iteration until the full number is reached or
+        until the iteration approaches convergence. Criterion (b) is applied only to iterations
+        that launched the full number of packets. Also if so requested, the secondary radiation
+        field is extrapolated between iterations to accelerate convergence (see
+        MediumSystem::extrapolateSecondaryRadiationField()). In that case, criterion (b) compares
+        the absorbed dust luminosity to the value for the extrapolated radiation field that served
+        as input for the iteration. */
     void runDustSelfAbsorptionPhase();
 
     /** This function runs the final secondary source emission segment. It implements a
@@ -236,7 +245,13 @@ private:
         to be handled. The \em primary flag is true to launch from primary sources, false for
         secondary sources. The \em peel flag indicates whether peeloff photon packets should be
         sent towards the instruments. The \em store flag indicates whether the contribution to the
-        radiation field should be stored. */
+        radiation field should be stored.
+
+        If the user requested wavelength grouping for an oligochromatic simulation, each primary
+        emission event launches a group of photon packets, one for each discrete wavelength, that
+        share the launch position and propagation direction. The geometric details of the emission
+        peel-off paths and of the initial path through the medium are then calculated only once for
+        the group, after which each packet in the group continues its life cycle independently. */
     void performLifeCycle(size_t firstIndex, size_t numIndices, bool primary, bool peel, bool store);
 
     /** This function implements the peel-off of a photon packet after an emission event. This
@@ -257,6 +272,19 @@ private:
         provides a placeholder peel off photon packet for use by the function. */
     void peelOffEmission(const PhotonPacket* pp, PhotonPacket* ppp);
 
+    /** This function implements the peel-off after an emission event for a group of photon
+        packets that share the launch position and propagation direction but carry different
+        wavelengths, as launched by the SourceSystem::launchWavelengthGroup() function. The
+        function behaves as the single packet version for each packet in the group, except that the
+        geometric details of the path towards a given instrument are calculated only once and then
+        copied to the peel-off photon packets for the other wavelengths. Photon packets with zero
+        luminosity are skipped.
+
+        The first two arguments specify the photon packets that were just emitted and the number of
+        packets in the group; the third argument provides a placeholder peel off photon packet for
+        each packet in the group. */
+    void peelOffEmission(const vector<PhotonPacket>& ppv, int numPackets, vector<PhotonPacket>& pppv);
+
     /** This function stores the contribution of the specified photon packet to the radiation field
         in the cells crossed by the packet's path. The function assumes that both the geometric and
         optical depth information for the photon packet's path have been set; if this is not the
@@ -351,6 +379,23 @@ private:
         information). The packet is now ready to be scattered into a new direction. */
     void simulatePropagation(PhotonPacket* pp);
 
+    /** This function determines the next scattering location of a photon packet and simulates its
+        propagation to that position, without requiring the path of the photon packet to be
+        calculated in advance. It is used instead of simulatePropagation() if the user enabled the
+        \em truncatePaths option and the radiation field is not being stored.
+
+        The function generates a random optical depth \f$\tau\f$ from the untruncated exponential
+        distribution \f$p(\tau)={\text{e}}^{-\tau}\f$, and asks the medium system to calculate the
+        path of the photon packet only until this optical depth is reached (see
+        MediumSystem::setInteractionPoint()). If the photon packet leaves the spatial grid before
+        that, it escapes and its luminosity is set to zero, terminating the packet. Otherwise the
+        weight of the photon packet is multiplied by the scattering albedo \f$\varpi\f$ in the
+        cell containing the interaction point, and the packet is advanced to that point. On
+        average, this procedure yields the same weight adjustment as the forced scattering scheme
+        implemented by simulatePropagation(), because a packet reaches an interaction point with
+        probability \f$1-\text{e}^{-\tau_\text{path}}\f$. */
+    void simulateTruncatedPropagation(PhotonPacket* pp);
+
     /** This function simulates the peel-off of a photon packet before a scattering event. This
         means that, just before a scattering event, we create a peel-off photon packet for every
         instrument in the instrument system, which is forced to propagate in the direction of the
@@ -8,6 +8,7 @@
 #include "Constants.hpp"
 #include "PhotonPacket.hpp"
 #include "Random.hpp"
+#include "WavelengthGrid.hpp"
 
 //////////////////////////////////////////////////////////////////////
 
@@ -23,6 +24,7 @@ void NormalizedSource::setupSelfBefore()
     {
         _xi = 1.;       // always use bias distribution for oligochromatic simulations
         _biasDistribution = config->oligoWavelengthBiasDistribution();
+        _oligoWavelengthGrid = config->wavelengthGrid(nullptr);
     }
     else
     {
@@ -123,3 +125,29 @@ void NormalizedSource::launch(PhotonPacket* pp, size_t historyIndex, double L) c
 }
 
 //////////////////////////////////////////////////////////////////////
+
+int NormalizedSource::launchWavelengthGroup(vector<PhotonPacket>& ppv, size_t historyIndex, double L) const
+{
+    // for panchromatic simulations, launch a single photon packet
+    if (!_oligochromatic) return Source::launchWavelengthGroup(ppv, historyIndex, L);
+
+    // calculate the compensating weight factor for each of the discrete wavelengths
+    int numWavelengths = _oligoWavelengthGrid->numBins();
+    auto weight = [this, numWavelengths] (double lambda)
+    {
+        double s = sed()->specificLuminosity(lambda);
+        return s ? s / (numWavelengths * _biasDistribution->probability(lambda)) : 0.;
+    };
+
+    // cause the subclass to launch the first photon packet, and copy the geometry to the others
+    double lambda0 = _oligoWavelengthGrid->wavelength(0);
+    launchNormalized(&ppv[0], historyIndex, lambda0, L*weight(lambda0), _bvi);
+    for (int k=1; k!=numWavelengths; ++k)
+    {
+        double lambda = _oligoWavelengthGrid->wavelength(k);
+        ppv[k].launchWavelengthSibling(&ppv[0], lambda, L*weight(lambda));
+    }
+    return numWavelengths;
+}
+
+//////////////////////////////////////////////////////////////////////
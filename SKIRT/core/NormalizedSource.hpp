@@ -10,6 +10,7 @@
 #include "VelocityInterface.hpp"
 #include "LuminosityNormalization.hpp"
 #include "SED.hpp"
+class WavelengthGrid;
 
 //////////////////////////////////////////////////////////////////////
 
@@ -109,6 +110,18 @@ public:
          the position and propagation direction of the emission from the geometry of the source. */
     void launch(PhotonPacket* pp, size_t historyIndex, double L) const override;
 
+    /** This function causes a group of photon packets to be launched from the source using the
+        given history index and luminosity contribution, and returns the number of photon packets
+        actually launched. For oligochromatic simulations, the function launches one photon packet
+        for each of the \f$K\f$ discrete wavelengths \f$\lambda_k\f$ in the simulation, all sharing
+        the position, propagation direction and polarization state determined by the subclass for
+        the first packet. Because each of the wavelengths would be selected with probability
+        \f$1/K\f$ by the oligochromatic bias distribution \f$b(\lambda)\f$, the packet with
+        wavelength \f$\lambda_k\f$ is assigned the luminosity contribution \f$L\,
+        s(\lambda_k)/(K\,b(\lambda_k))\f$. For panchromatic simulations, the function simply
+        launches a single photon packet through the launch() function. */
+    int launchWavelengthGroup(vector<PhotonPacket>& ppv, size_t historyIndex, double L) const override;
+
     //============== Functions to be implemented in each subclass =============
 
     /** This function returns the dimension of the spatial distribution implemented by the
@@ -131,6 +144,7 @@ private:
     bool _oligochromatic{false};    // true if the simulation is oligochromatic
     double _xi{0.};                 // the wavelength bias fraction
     WavelengthDistribution* _biasDistribution{nullptr}; // the wavelength bias distribution
+    WavelengthGrid* _oligoWavelengthGrid{nullptr};      // the discrete wavelengths for oligochromatic simulations
 
     // pointer to an object offering the redshift interface; either "this" or null pointer if the bulk velocity is zero
     VelocityInterface* _bvi{nullptr};
@@ -35,7 +35,95 @@ class PhotonPacketOptions : public SimulationItem
         ATTRIBUTE_DEFAULT_VALUE(pathLengthBias, "0.5")
         ATTRIBUTE_DISPLAYED_IF(pathLengthBias, "Level3")
 
+    PROPERTY_BOOL(threadPrivateRadiationField,
+                  "accumulate the radiation field in a separate table for each execution thread")
+        ATTRIBUTE_DEFAULT_VALUE(threadPrivateRadiationField, "false")
+        ATTRIBUTE_DISPLAYED_IF(threadPrivateRadiationField, "Level3")
+
+    PROPERTY_BOOL(singlePrecisionRadiationField,
+                  "store the radiation field tables in single precision to reduce memory usage")
+        ATTRIBUTE_DEFAULT_VALUE(singlePrecisionRadiationField, "false")
+        ATTRIBUTE_DISPLAYED_IF(singlePrecisionRadiationField, "Level3")
+
+    PROPERTY_BOOL(skipEmptySpace,
+                  "cross regions without material in a single step when calculating paths through the grid")
+        ATTRIBUTE_DEFAULT_VALUE(skipEmptySpace, "false")
+        ATTRIBUTE_DISPLAYED_IF(skipEmptySpace, "Level3")
+
+    PROPERTY_BOOL(truncatePaths,
+                  "calculate paths only up to the interaction point when the radiation field is not stored")
+        ATTRIBUTE_DEFAULT_VALUE(truncatePaths, "false")
+        ATTRIBUTE_DISPLAYED_IF(truncatePaths, "Level3")
+
+    PROPERTY_BOOL(groupWavelengths,
+                  "launch a photon packet for each wavelength from every emission event, sharing the initial path")
+        ATTRIBUTE_DEFAULT_VALUE(groupWavelengths, "false")
+        ATTRIBUTE_RELEVANT_IF(groupWavelengths, "Oligochromatic")
+        ATTRIBUTE_DISPLAYED_IF(groupWavelengths, "Level3")
+
     ITEM_END()
+
+    /** \fn threadPrivateRadiationField
+        By default, all execution threads in a process accumulate the radiation field into a single
+        shared table using atomic operations. With many threads, this causes contention for the
+        table entries corresponding to dense cells that are crossed by many photon packets. If this
+        flag is enabled, each execution thread accumulates the radiation field into its own private
+        table, and the private tables are merged into the shared table at the end of each
+        simulation segment. This avoids the contention at the cost of an additional radiation field
+        table per execution thread, as reported in the memory allocation log message issued by the
+        medium system. */
+
+    /** \fn singlePrecisionRadiationField
+        By default, the radiation field tables maintained by the medium system store each value in
+        double precision. For spatial grids with many cells, these tables (up to three of them in
+        simulations with secondary emission) can dominate the memory usage of the simulation. If
+        this flag is enabled, the shared tables store each value in single precision, halving
+        their memory requirements as reported in the memory allocation log message issued by the
+        medium system. All calculations using the table entries are still performed in double
+        precision. To avoid rounding each individual contribution to single precision, this flag
+        implies the thread-private radiation field option: the radiation field is accumulated in
+        double precision thread-private tables, which are added to the shared tables only at the end
+        of each simulation segment. The memory saved in the shared tables should thus be weighed
+        against the memory required for the thread-private tables, which is also reported in the
+        memory allocation log message. Hence this option is useful mostly for simulations with
+        large spatial grids running with only a few execution threads per process. */
+
+    /** \fn skipEmptySpace
+        If this flag is enabled, the medium system informs the spatial grid about the cells that
+        contain no material at all, so that the grid can cross a region of such cells in a single
+        step when calculating a path. This reduces the number of path segments, and thus the time
+        spent calculating optical depths, for models with large density-free regions. Because the
+        radiation field is not recorded in the skipped cells, paths are calculated in this way only
+        when no radiation field needs to be stored, e.g. for peel-off photon packets towards the
+        instruments. Currently, only tree grids use this information; other spatial grids ignore it.
+        */
+
+    /** \fn truncatePaths
+        By default, the path of a photon packet is calculated up to the edge of the spatial grid,
+        because the total optical depth along the path is needed to force the next interaction to
+        occur within the grid. If this flag is enabled, photon packets in simulation segments that
+        do not store the radiation field (e.g., the final secondary emission segment, or any
+        segment of an extinction-only simulation without radiation field output) instead sample the
+        interaction optical depth from the untruncated exponential distribution, and the path is
+        calculated only until that optical depth is reached. A photon packet that leaves the grid
+        before reaching the interaction point is terminated; its escaping luminosity is accounted
+        for by the peel-off photon packets. This avoids most of the path calculation for optically
+        thick models, at the cost of somewhat increased noise because fewer photon packets reach
+        the scattering events deep in the medium. The path length bias option does not apply to
+        these segments. */
+
+    /** \fn groupWavelengths
+        If this flag is enabled in an oligochromatic simulation, each emission event launches a
+        group of photon packets, one for each of the discrete wavelengths in the simulation, rather
+        than a single photon packet with a randomly selected wavelength. The packets in a group
+        share the launch position and propagation direction, so that the geometric details of the
+        emission peel-off paths towards the instruments and of the initial path through the medium
+        are calculated only once for the whole group; only the optical depths along the shared
+        segments are calculated for each wavelength separately. After the first interaction, each
+        packet continues its life cycle independently. Because the number of emission events is
+        unchanged, the total number of photon packets traced increases by a factor equal to the
+        number of wavelengths, which usually reduces the noise at a lower cost than launching the
+        same number of independent packets. */
 };
 
 ////////////////////////////////////////////////////////////////////
@@ -0,0 +1,124 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "RadiationFieldTable.hpp"
+#include "FatalError.hpp"
+#include "LockFree.hpp"
+#include "ProcessManager.hpp"
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the number of single precision entries communicated between processes in one chunk
+    const size_t communicationChunkSize = 1 << 24;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RadiationFieldTable::resize(size_t numCells, size_t numBins, bool singlePrecision)
+{
+    _numCells = numCells;
+    _numBins = numBins;
+    _singlePrecision = singlePrecision;
+    if (_singlePrecision)
+    {
+        _dv.resize(0);
+        _fv.assign(size(), 0.f);
+    }
+    else
+    {
+        _fv.clear();
+        _fv.shrink_to_fit();
+        _dv.resize(size());
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RadiationFieldTable::add(int m, int ell, double value)
+{
+    if (_singlePrecision) throw FATALERROR("Cannot accumulate directly into a single precision radiation field table");
+    LockFree::add(_dv[static_cast<size_t>(m)*_numBins + ell], value);
+}
+
+////////////////////////////////////////////////////////////////////
+
+double RadiationFieldTable::weightedSum(int m, const double* wv) const
+{
+    size_t begin = static_cast<size_t>(m)*_numBins;
+    double sum = 0.;
+    if (_singlePrecision)
+    {
+        const float* fv = _fv.data() + begin;
+        for (size_t ell=0; ell!=_numBins; ++ell) sum += wv[ell] * static_cast<double>(fv[ell]);
+        return std::ldexp(sum, -scaleExponent);
+    }
+    else
+    {
+        const double* dv = &_dv[begin];
+        for (size_t ell=0; ell!=_numBins; ++ell) sum += wv[ell] * dv[ell];
+        return sum;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RadiationFieldTable::setToZero()
+{
+    if (_singlePrecision) std::fill(_fv.begin(), _fv.end(), 0.f);
+    else _dv = 0.;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RadiationFieldTable::addAndClear(Table<2>& source, size_t firstCell, size_t numCells)
+{
+    size_t begin = firstCell*_numBins;
+    size_t end = (firstCell+numCells)*_numBins;
+    Array& sourcev = source.data();
+    if (_singlePrecision)
+    {
+        for (size_t i=begin; i!=end; ++i)
+        {
+            _fv[i] = toSingle(fromSingle(_fv[i]) + sourcev[i]);
+            sourcev[i] = 0.;
+        }
+    }
+    else
+    {
+        for (size_t i=begin; i!=end; ++i)
+        {
+            _dv[i] += sourcev[i];
+            sourcev[i] = 0.;
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void RadiationFieldTable::sumToAll()
+{
+    if (!ProcessManager::isMultiProc()) return;
+
+    if (_singlePrecision)
+    {
+        Array chunk;
+        for (size_t begin=0; begin<_fv.size(); begin+=communicationChunkSize)
+        {
+            size_t n = min(communicationChunkSize, _fv.size()-begin);
+            chunk.resize(n);
+            for (size_t i=0; i!=n; ++i) chunk[i] = fromSingle(_fv[begin+i]);
+            ProcessManager::sumToAll(chunk);
+            for (size_t i=0; i!=n; ++i) _fv[begin+i] = toSingle(chunk[i]);
+        }
+    }
+    else
+    {
+        ProcessManager::sumToAll(_dv);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,118 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef RADIATIONFIELDTABLE_HPP
+#define RADIATIONFIELDTABLE_HPP
+
+#include "Table.hpp"
+#include <cmath>
+
+////////////////////////////////////////////////////////////////////
+
+/** A RadiationFieldTable instance holds the radiation field accumulated during the photon cycle,
+    with an entry for each spatial cell and for each bin in the radiation field wavelength grid
+    (indexed on m,ell). The table entries are stored in double precision by default, or in single
+    precision if so requested when the table is sized. Single precision halves the memory
+    requirements of the table, which are often dominated by the number of cells in the spatial
+    grid, at the cost of some precision in the accumulated values. All arithmetic on the table
+    entries, including the summation of values across multiple processes, is performed in double
+    precision; the values are rounded to single precision only when they are stored.
+
+    The values accumulated in the table are luminosities multiplied by path lengths, expressed in
+    SI units, which easily exceed the range of single precision floating point numbers. Therefore
+    the single precision entries hold the values multiplied by the constant scale factor
+    \f$2^{-100}\approx 7.9\times10^{-31}\f$, so that the representable range of values extends from
+    about \f$10^{-8}\f$ to \f$4\times10^{68}\f$. Because the scale factor is a power of two,
+    the scaling does not introduce any rounding errors.
+
+    Rounding each individual contribution to single precision would systematically lose the
+    contributions that are small compared to the value already accumulated in a table entry.
+    Therefore a single precision table does not support direct accumulation through the add()
+    function. Instead, the radiation field is accumulated in thread-private double precision
+    tables, which are added to the single precision table using the addAndClear() function at the
+    end of each simulation segment, so that each entry is rounded only once per thread and per
+    segment. */
+class RadiationFieldTable
+{
+public:
+    /** This function resizes the table to the specified number of cells and wavelength bins and
+        sets all entries to zero. If the \em singlePrecision flag is true, the entries are stored in
+        single precision; otherwise they are stored in double precision. */
+    void resize(size_t numCells, size_t numBins, bool singlePrecision);
+
+    /** This function returns the number of entries in the table, or zero if the table has not been
+        sized. */
+    size_t size() const { return _numCells*_numBins; }
+
+    /** This function returns the number of bytes allocated for the table entries. */
+    size_t allocatedBytes() const { return _singlePrecision ? _fv.size()*sizeof(float) : _dv.size()*sizeof(double); }
+
+    /** This function returns the value of the table entry for the specified cell and wavelength
+        bin. */
+    double operator()(int m, int ell) const
+    {
+        size_t i = static_cast<size_t>(m)*_numBins + ell;
+        return _singlePrecision ? fromSingle(_fv[i]) : _dv[i];
+    }
+
+    /** This function returns the sum of the table entries for the specified cell, weighted by the
+        values in the specified array, i.e. \f$\sum_\ell w_\ell\,T_{m,\ell}\f$. The array must
+        have an element for each wavelength bin. */
+    double weightedSum(int m, const double* wv) const;
+
+    /** This function adds the specified value to the table entry for the specified cell and
+        wavelength bin in a thread-safe manner. It can be used only for tables stored in double
+        precision; for single precision tables, it throws a fatal error. */
+    void add(int m, int ell, double value);
+
+    /** This function sets the table entry for the specified cell and wavelength bin to the
+        specified value. In contrast to the add() function, this function is not thread-safe for a
+        given table entry. */
+    void set(int m, int ell, double value)
+    {
+        size_t i = static_cast<size_t>(m)*_numBins + ell;
+        if (_singlePrecision) _fv[i] = toSingle(value);
+        else _dv[i] = value;
+    }
+
+    /** This function sets all entries in the table to zero. */
+    void setToZero();
+
+    /** This function adds the entries of the specified table with double precision values, which
+        must have the same dimensions as this table, to the entries of this table, and sets the
+        entries of the specified table to zero. Only the entries for the cells in the specified
+        range are processed, so that multiple parallel threads can handle disjoint ranges of cells.
+        */
+    void addAndClear(Table<2>& source, size_t firstCell, size_t numCells);
+
+    /** This function adds the table entries element-wise across the different processes, storing
+        the resulting sums in the table on each individual process. All processes must call this
+        function for the communication to proceed. If there is only one process, the function does
+        nothing. For single precision tables, the communication is performed in double precision
+        for consecutive chunks of entries, so that there is no need to allocate a double precision
+        copy of the complete table. */
+    void sumToAll();
+
+private:
+    // the base-2 exponent of the scale factor applied to single precision entries
+    static constexpr int scaleExponent = -100;
+
+    /** This function converts a double precision value to a scaled single precision value. */
+    static float toSingle(double value) { return static_cast<float>(std::ldexp(value, scaleExponent)); }
+
+    /** This function converts a scaled single precision value to a double precision value. */
+    static double fromSingle(float value) { return std::ldexp(static_cast<double>(value), -scaleExponent); }
+
+private:
+    size_t _numCells{0};
+    size_t _numBins{0};
+    bool _singlePrecision{false};
+    Array _dv;              // the entries in double precision (indexed on m*numBins+ell), if applicable
+    vector<float> _fv;      // the entries in single precision (indexed on m*numBins+ell), if applicable
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
@@ -49,11 +49,98 @@ namespace
         }
     };
 
+    // This helper class represents a counter-based pseudo-random generator implementing the
+    // Philox4x32-10 algorithm (Salmon et al. 2011). Each deviate is a stateless function of the
+    // key (seed and segment) and the counter (history index and deviate sequence number).
+    class HistoryRand
+    {
+    private:
+        // number of deviates generated in a single block; each Philox call yields two deviates
+        static const int blockSize = 8;
+
+        uint32_t _key[2]{0,0};      // seed, segment
+        uint64_t _history{0};       // history index
+        uint64_t _numDrawn{0};      // number of deviates drawn so far in this history
+        double _block[blockSize];   // current block of deviates
+        bool _active{false};
+
+        // perform the ten Philox rounds for the given counter, returning the four 32-bit outputs
+        static void philox(uint32_t k0, uint32_t k1, uint32_t c[4])
+        {
+            const uint64_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+            const uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+            for (int round=0; round!=10; ++round)
+            {
+                uint64_t p0 = M0 * c[0];
+                uint64_t p1 = M1 * c[2];
+                uint32_t c0 = static_cast<uint32_t>(p1>>32) ^ c[1] ^ k0;
+                uint32_t c2 = static_cast<uint32_t>(p0>>32) ^ c[3] ^ k1;
+                c[0] = c0;
+                c[1] = static_cast<uint32_t>(p1);
+                c[2] = c2;
+                c[3] = static_cast<uint32_t>(p0);
+                k0 += W0;
+                k1 += W1;
+            }
+        }
+
+        // convert 64 random bits to a double in the open interval (0,1)
+        static double toDouble(uint32_t hi, uint32_t lo)
+        {
+            uint64_t bits = (static_cast<uint64_t>(hi)<<32) | lo;
+            return ((bits>>11) + 0.5) * (1./9007199254740992.);
+        }
+
+        // fill the block of deviates containing the deviate with the given sequence number
+        void fillBlock(uint64_t sequence)
+        {
+            uint64_t firstCall = (sequence / blockSize) * (blockSize/2);
+            for (int j=0; j!=blockSize/2; ++j)
+            {
+                uint64_t call = firstCall+j;
+                uint32_t c[4] = { static_cast<uint32_t>(_history), static_cast<uint32_t>(_history>>32),
+                                  static_cast<uint32_t>(call), static_cast<uint32_t>(call>>32) };
+                philox(_key[0], _key[1], c);
+                _block[2*j] = toDouble(c[0], c[1]);
+                _block[2*j+1] = toDouble(c[2], c[3]);
+            }
+        }
+
+    public:
+        // start the stream for the given key and history
+        void start(int seed, int segment, uint64_t history)
+        {
+            _key[0] = static_cast<uint32_t>(seed);
+            _key[1] = static_cast<uint32_t>(segment);
+            _history = history;
+            _numDrawn = 0;
+            _active = true;
+        }
+
+        // stop the stream
+        void stop() { _active = false; }
+
+        // return true if the stream is active
+        bool active() const { return _active; }
+
+        // get uniform deviate
+        double get()
+        {
+            int index = _numDrawn % blockSize;
+            if (!index) fillBlock(_numDrawn);
+            _numDrawn++;
+            return _block[index];
+        }
+    };
+
     // allocate two random generators for each thread, and a pointer to the current generator
     // (these objects are constructed and initialized when the thread is created)
     thread_local Rand _predictable;
     thread_local Rand _arbitrary;
     thread_local Rand* _rand = &_arbitrary;
+
+    // allocate a history stream generator for each thread
+    thread_local HistoryRand _history;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -85,9 +172,30 @@ void Random::switchToPredictable()
 
 //////////////////////////////////////////////////////////////////////
 
+void Random::startSegment()
+{
+    _segment++;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Random::startHistory(size_t historyIndex)
+{
+    if (historyStreams()) _history.start(seed(), _segment, historyIndex);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void Random::stopHistory()
+{
+    _history.stop();
+}
+
+//////////////////////////////////////////////////////////////////////
+
 double Random::uniform()
 {
-    return _rand->get();
+    return _history.active() ? _history.get() : _rand->get();
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -59,8 +59,31 @@ class Position;
     run-time hierarchy will then call the switchToArbitrary() and switchToPredictable() functions
     at the appropriate times.
 
-    All rng's used in this class are based on the 64-bit Mersenne twister, which offers a
-    sufficiently long period and acceptable spectral properties for most purposes. */
+    The arbitrary and predictable rng's used in this class are based on the 64-bit Mersenne
+    twister, which offers a sufficiently long period and acceptable spectral properties for most
+    purposes.
+
+    <b>History streams</b>
+
+    With the mechanism described above, the random sequence seen by a particular photon packet
+    history depends on the thread (and process) that happens to trace it, so that results change
+    with the number of threads or processes. To avoid this, the user can enable the \em
+    historyStreams property. The photon life cycle then calls the startHistory() function before
+    tracing each photon packet history, and the stopHistory() function when it is done. While a
+    history is active, the uniform() function (and thus all other functions generating random
+    numbers) draws its deviates from a counter-based generator, i.e. a generator that calculates
+    each deviate as a stateless function of a key and a counter. The key is formed from the \em
+    seed property and the index of the current simulation segment (see startSegment()), and the
+    counter is formed from the photon packet history index and the sequence number of the deviate
+    within the history. As a result, each history sees exactly the same random sequence regardless
+    of how histories are distributed over threads and processes. Other parallelized tasks that
+    consume random numbers, such as sampling the density in the nodes of a tree grid under
+    construction, use the same mechanism by treating each task item as a history.
+
+    The counter-based generator implements the Philox4x32-10 algorithm described by Salmon et al.
+    (2011, Proceedings of SC11, 16). It produces uniform deviates in blocks of eight, which allows
+    the compiler to vectorize the computation. The per-thread state is limited to the key, the
+    counter and a single block of deviates. */
 class Random : public SimulationItem
 {
     ITEM_CONCRETE(Random, SimulationItem, "the default random generator")
@@ -71,6 +94,10 @@ class Random : public SimulationItem
         ATTRIBUTE_DEFAULT_VALUE(seed, "0")
         ATTRIBUTE_DISPLAYED_IF(seed, "Level3")
 
+    PROPERTY_BOOL(historyStreams, "use a separate reproducible random stream for each photon packet history")
+        ATTRIBUTE_DEFAULT_VALUE(historyStreams, "false")
+        ATTRIBUTE_DISPLAYED_IF(historyStreams, "Level3")
+
     ITEM_END()
 
     //============= Construction - Setup - Destruction =============
@@ -92,6 +119,32 @@ public:
         only from the parent thread, i.e. the thread that called setup() on this instance. */
     void switchToPredictable();
 
+    //================= History stream functions ====================
+
+public:
+    /** This function notifies the random generator that a new simulation segment (e.g., primary
+        emission, a dust self-absorption iteration, or secondary emission) is about to start. The
+        function increments the segment index that is used, together with the \em seed property,
+        to form the key for the history streams, so that photon packets with the same history index
+        in different segments receive independent random sequences. Because all processes perform
+        the same segments in the same order, the segment index is consistent across processes. The
+        function should be called only from the parent thread, outside of any parallel section. */
+    void startSegment();
+
+    /** This function returns the index of the current simulation segment, i.e. the number of times
+        the startSegment() function has been called. */
+    int segment() const { return _segment; }
+
+    /** If the \em historyStreams property is enabled, this function causes the calling thread to
+        draw its random deviates from the counter-based random stream for the photon packet history
+        with the specified index in the current segment. If the \em historyStreams property is
+        disabled, the function does nothing. */
+    void startHistory(size_t historyIndex);
+
+    /** This function causes the calling thread to stop drawing random deviates from a history
+        stream and to return to its regular generator. */
+    void stopHistory();
+
     //======================== Other Functions =======================
 
 public:
@@ -171,6 +224,12 @@ public:
         generalized exponential, defined in the description of respectively the
         SpecialFunctions::gln() and SpecialFunctions::gexp() functions. */
     double cdfLogLog(const Array& xv, const Array& pv, const Array& Pv);
+
+    //======================== Data Members ========================
+
+private:
+    // index of the current simulation segment, used as part of the key for the history streams
+    int _segment{0};
 };
 
 //////////////////////////////////////////////////////////////////////
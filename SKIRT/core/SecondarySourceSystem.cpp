@@ -119,6 +119,10 @@ bool SecondarySourceSystem::prepareForLaunch(size_t numPackets)
     }
     _Iv[numCells] = numPackets;
 
+    // --------- emission spectra ---------
+
+    if (_config->precalculateEmissionSpectra()) precalculateEmissionSpectra();
+
     // --------- logging ---------
 
     auto log = find<Log>();
@@ -162,6 +166,160 @@ bool SecondarySourceSystem::prepareForLaunch(size_t numPackets)
 
 ////////////////////////////////////////////////////////////////////
 
+void SecondarySourceSystem::precalculateEmissionSpectra()
+{
+    auto log = find<Log>();
+    int numCells = _ms->numCells();
+
+    // release the spectra precalculated for a previous segment, keeping them around for possible reuse
+    _kv.clear();
+    Array prevevv, prevJvv;
+    vector<int> preventryv;
+    std::swap(prevevv, _evv);
+    std::swap(prevJvv, _Jvv);
+    std::swap(preventryv, _entryv);
+
+    // construct a list of dust media and determine the number of wavelengths in the emission spectra
+    // and in the radiation field
+    vector<int> hv;
+    for (int h=0; h!=_ms->numMedia(); ++h) if (_ms->isDust(h)) hv.push_back(h);
+    size_t numMedia = hv.size();
+    size_t numWavelengths = _config->dustEmissionWLG()->extlambdav().size();
+    const Array& dlambdav = _config->radiationFieldWLG()->dlambdav();
+    size_t numFieldWavelengths = dlambdav.size();
+
+    // determine the range of launch-order cell indices for each library entry that has emitting cells;
+    // these ranges are consecutive because the cells have been sorted on library entry index
+    vector<int> firstv;     // the first launch-order cell index for each used library entry
+    vector<int> countv;     // the number of cells mapped to each used library entry
+    vector<int> entryv;     // the library entry index for each used library entry
+    vector<int> kv(numCells, -1);
+    for (int p=0; p!=numCells; )
+    {
+        int n = _nv[_mv[p]];
+        int pp = p+1;
+        for (; pp!=numCells; ++pp) if (_nv[_mv[pp]] != n) break;
+
+        bool emitting = false;
+        for (int q=p; q!=pp; ++q) if (_Lv[_mv[q]] > 0.) emitting = true;
+        if (n >= 0 && emitting)
+        {
+            for (int q=p; q!=pp; ++q) kv[q] = firstv.size();
+            firstv.push_back(p);
+            countv.push_back(pp-p);
+            entryv.push_back(n);
+        }
+        p = pp;
+    }
+    size_t numEntries = firstv.size();
+
+    // verify that the spectra and the corresponding radiation fields fit in the configured memory budget
+    size_t numBytes = numEntries * (numMedia*numWavelengths + numFieldWavelengths) * sizeof(double);
+    if (numBytes > _config->maxEmissionSpectraMemory() * 1e9)
+    {
+        log->info("Calculating dust emission spectra on the fly because storing them would require "
+                  + StringUtils::toMemSizeString(numBytes));
+        return;
+    }
+
+    auto parallel = find<ParallelFactory>()->parallelDistributed();
+
+    // calculate the average radiation field for the cells mapped to each used library entry
+    _Jvv.resize(numEntries * numFieldWavelengths);
+    parallel->call(numEntries, [this, &firstv, &countv, numFieldWavelengths] (size_t firstIndex, size_t numIndices)
+    {
+        for (size_t k=firstIndex; k!=firstIndex+numIndices; ++k)
+        {
+            int p = firstv[k];
+            Array Jv = _ms->meanIntensity(_mv[p]);
+            for (int i=1; i!=countv[k]; ++i) Jv += _ms->meanIntensity(_mv[p+i]);
+            Jv /= countv[k];
+            std::copy(begin(Jv), end(Jv), begin(_Jvv) + k*numFieldWavelengths);
+        }
+    });
+    ProcessManager::sumToAll(_Jvv);
+
+    // determine the library entries for which the spectra calculated for a previous segment can be reused
+    // because the average radiation field has changed less than the configured fraction
+    vector<int> reusev(numEntries, -1);     // the index k in the previous segment for each reused entry, or -1
+    double threshold = _config->emissionSpectrumReuseThreshold();
+    if (threshold > 0. && !preventryv.empty())
+    {
+        int maxEntry = max(*std::max_element(entryv.cbegin(), entryv.cend()),
+                           *std::max_element(preventryv.cbegin(), preventryv.cend()));
+        vector<int> prevkv(maxEntry+1, -1);
+        for (size_t k=0; k!=preventryv.size(); ++k) prevkv[preventryv[k]] = k;
+
+        for (size_t k=0; k!=numEntries; ++k)
+        {
+            int pk = prevkv[entryv[k]];
+            if (pk >= 0)
+            {
+                const double* Jv = &_Jvv[k*numFieldWavelengths];
+                const double* prevJv = &prevJvv[pk*numFieldWavelengths];
+                double diff = 0.;
+                double sum = 0.;
+                for (size_t ell=0; ell!=numFieldWavelengths; ++ell)
+                {
+                    diff += abs(Jv[ell] - prevJv[ell]) * dlambdav[ell];
+                    sum += prevJv[ell] * dlambdav[ell];
+                }
+                if (diff < threshold*sum) reusev[k] = pk;
+            }
+        }
+    }
+
+    // construct the list of library entries for which the spectra must be calculated
+    vector<int> calcv;
+    for (size_t k=0; k!=numEntries; ++k) if (reusev[k] < 0) calcv.push_back(k);
+    size_t numCalc = calcv.size();
+
+    // calculate the emissivity spectra for these library entries, distributing the entries over threads and processes
+    log->info("Calculating dust emission spectra for " + std::to_string(numCalc) + " library entries...");
+    _evv.resize(numEntries * numMedia * numWavelengths);
+    parallel->call(numCalc, [this, &hv, &firstv, &calcv, numMedia, numWavelengths, numFieldWavelengths]
+                   (size_t firstIndex, size_t numIndices)
+    {
+        for (size_t j=firstIndex; j!=firstIndex+numIndices; ++j)
+        {
+            size_t k = calcv[j];
+            int m = _mv[firstv[k]];
+            Array Jv(&_Jvv[k*numFieldWavelengths], numFieldWavelengths);
+
+            for (size_t i=0; i!=numMedia; ++i)
+            {
+                Array ev = _ms->mix(m,hv[i])->emissivity(Jv);
+                std::copy(begin(ev), end(ev), begin(_evv) + (k*numMedia+i)*numWavelengths);
+            }
+        }
+    });
+    ProcessManager::sumToAll(_evv);
+
+    // copy the reused spectra, and remember the radiation field for which they were actually calculated
+    size_t numReused = numEntries - numCalc;
+    for (size_t k=0; k!=numEntries; ++k)
+    {
+        int pk = reusev[k];
+        if (pk >= 0)
+        {
+            std::copy(begin(prevevv) + pk*numMedia*numWavelengths, begin(prevevv) + (pk+1)*numMedia*numWavelengths,
+                      begin(_evv) + k*numMedia*numWavelengths);
+            std::copy(begin(prevJvv) + pk*numFieldWavelengths, begin(prevJvv) + (pk+1)*numFieldWavelengths,
+                      begin(_Jvv) + k*numFieldWavelengths);
+        }
+    }
+    if (numReused) log->info("  Reused " + std::to_string(numReused) + " dust emission spectra from the previous segment");
+
+    // keep the radiation fields only if they may be needed for the next segment
+    if (threshold > 0.) _entryv = std::move(entryv);
+    else _Jvv.resize(0);
+    _kv = std::move(kv);
+
+    log->info("  Stored dust emission spectra in " + StringUtils::toMemSizeString(numBytes));
+}
+
+////////////////////////////////////////////////////////////////////
+
 namespace
 {
     // An instance of this class obtains and/or calculates the information needed to launch photon packets
@@ -195,10 +353,12 @@ namespace
         //   p:  launch-order cell index (cells mapped to a given library entry have consecutive p indices)
         //   mv: map from launch-order cell index p to regular cell index m
         //   nv: map from regular cell index m to library entry index n
+        //   kv: map from launch-order cell index p to precalculated spectra index k, or empty if not precalculated
+        //   evv: precalculated emissivity spectra (indexed on k,h,ell), if applicable
         //   ms: medium system
         //   config: configuration object
         void calculateIfNeeded(int p, const vector<int>& mv, const vector<int>& nv,
-                               MediumSystem* ms, Configuration* config)
+                               const vector<int>& kv, const Array& evv, MediumSystem* ms, Configuration* config)
         {
             // if this photon packet is launched from the same cell as the previous one, we don't need to do anything
             if (p == _p) return;
@@ -228,40 +388,54 @@ namespace
                 // remember the new library entry index
                 _n = n;
 
-                // determine the number of cells mapped to this library entry (they are consecutive in p)
-                int pp = p+1;
-                for (; pp!=_numCells; ++pp) if (nv[mv[pp]] != n) break;
-                int numMappedCells = pp - p;
-
-                // if only a single cell maps to the library entry, we can simply calculate its emission
-                if (numMappedCells == 1)
+                // if the emissivity spectra have been precalculated, simply copy them for each medium component
+                // and apply the relative density weights for this cell
+                if (!kv.empty())
                 {
-                    calculateSingleSpectrum(_ms->meanIntensity(m), m);
+                    size_t k = kv[p];
+                    for (int i=0; i!=_numMedia; ++i)
+                        _evv[_hv[i]] = Array(&evv[(k*_numMedia+i)*_numWavelengths], _numWavelengths);
+                    calculateWeightedSpectrum(m);
                 }
 
-                // if multiple cells map to the library entry, we use the average radiation field for these cells
+                // otherwise, calculate the emissivity spectra for the average radiation field of the mapped cells
                 else
                 {
-                    Array Jv = _ms->meanIntensity(m);
-                    for (int i=1; i!=numMappedCells; ++i) Jv += _ms->meanIntensity(mv[p+i]);
-                    Jv /= numMappedCells;
-
-                    // if there is a single dust medium (and assuming that there are no variable dust mixes),
-                    // we can use a single emission spectrum for all cells mapped to the library entry, calculated
-                    // using the average radiation field, because the cells differ only in dust density, which is
-                    // irrelevant because the emission spectrum is normalized anyway
-                    if (_numMedia == 1)
+                    // determine the number of cells mapped to this library entry (they are consecutive in p)
+                    int pp = p+1;
+                    for (; pp!=_numCells; ++pp) if (nv[mv[pp]] != n) break;
+                    int numMappedCells = pp - p;
+
+                    // if only a single cell maps to the library entry, we can simply calculate its emission
+                    if (numMappedCells == 1)
                     {
-                        calculateSingleSpectrum(Jv, m);
+                        calculateSingleSpectrum(_ms->meanIntensity(m), m);
                     }
 
-                    // otherwise, we need to calculate and remember the emission spectrum for each medium component
-                    // (still using the average radiation field and assuming that there are no variable dust mixes)
-                    // so that we can apply the relative density weights for each cell later on
+                    // if multiple cells map to the library entry, we use the average radiation field for these cells
                     else
                     {
-                        calculateEmissivityPerMedium(Jv, m);
-                        calculateWeightedSpectrum(m);
+                        Array Jv = _ms->meanIntensity(m);
+                        for (int i=1; i!=numMappedCells; ++i) Jv += _ms->meanIntensity(mv[p+i]);
+                        Jv /= numMappedCells;
+
+                        // if there is a single dust medium (and assuming that there are no variable dust mixes),
+                        // we can use a single emission spectrum for all cells mapped to the library entry, calculated
+                        // using the average radiation field, because the cells differ only in dust density, which is
+                        // irrelevant because the emission spectrum is normalized anyway
+                        if (_numMedia == 1)
+                        {
+                            calculateSingleSpectrum(Jv, m);
+                        }
+
+                        // otherwise, we need to calculate and remember the emission spectrum for each medium component
+                        // (still using the average radiation field and assuming that there are no variable dust mixes)
+                        // so that we can apply the relative density weights for each cell later on
+                        else
+                        {
+                            calculateEmissivityPerMedium(Jv, m);
+                            calculateWeightedSpectrum(m);
+                        }
                     }
                 }
             }
@@ -344,7 +518,7 @@ void SecondarySourceSystem::launch(PhotonPacket* pp, size_t historyIndex) const
     auto m = _mv[p];
 
     // calculate the emission spectrum and bulk velocity for this cell, if not already available
-    t_dustcell.calculateIfNeeded(p, _mv, _nv, _ms, _config);
+    t_dustcell.calculateIfNeeded(p, _mv, _nv, _kv, _evv, _ms, _config);
 
     // generate a random wavelength from the emission spectrum for the cell and/or from the bias distribution
     double lambda, w;
@@ -121,7 +121,37 @@ class Random;
     result must be calculated and stored for each cell separately. If the medium system has only a
     single dust component, the above formula reduces to \f$j_{m,\ell} =\rho_m\,
     \varepsilon_{n,\ell}\f$, so that the normalized emission spectrum is identical for all spatial
-    cells that map to a certain library entry. */
+    cells that map to a certain library entry.
+
+    Precalculating emission spectra
+    -------------------------------
+
+    Calculating the emission spectra on the fly as described above has two drawbacks. Firstly,
+    when the chunk of history indices handled by an execution thread starts or ends in the middle
+    of the range allocated to a library entry, multiple threads redo the same, possibly very
+    time-consuming, emissivity calculation. Secondly, the work load for the threads can be very
+    uneven, because it is dominated by the number of library entries encountered by each thread
+    rather than by the number of photon packets it launches.
+
+    Therefore, if so requested by the configuration, the prepareForLaunch() function calculates the
+    emissivity spectra \f$\varepsilon_{n,h,\ell}\f$ for all library entries that have emitting
+    cells in advance, in parallel and distributed across processes, and stores the results in a
+    single table that is shared by all execution threads. The launch() function then only needs to
+    combine and normalize these spectra for each cell. The memory requirements for the table are
+    proportional to the number of library entries, the number of dust components, and the number
+    of wavelengths in the dust emission grid. If the table would require more memory than the
+    configured limit, the prepareForLaunch() function reverts to the on-the-fly mechanism.
+
+    In simulations with dust self-absorption, the radiation field in most library entries often
+    changes very little from one iteration to the next. Therefore, if so requested by the
+    configuration, the prepareForLaunch() function remembers the average radiation field for which
+    the spectra of each library entry were calculated. In the next segment, it reuses the spectra
+    for library entries for which the bolometric relative change of the average radiation field,
+    i.e. \f[ \frac{\sum_k |J_{n,k} - J_{n,k}^\text{prev}|\,\Delta\lambda_k}{\sum_k
+    J_{n,k}^\text{prev}\,\Delta\lambda_k}, \f] is smaller than the configured threshold, and
+    recalculates the spectra only for the other entries. The change is always measured relative to
+    the radiation field for which the reused spectra were actually calculated, so that small
+    changes cannot accumulate over multiple segments without triggering a recalculation. */
 class SecondarySourceSystem : public SimulationItem
 {
     //============= Construction - Setup - Destruction =============
@@ -154,6 +184,19 @@ public:
         launched), and true otherwise. */
     bool prepareForLaunch(size_t numPackets);
 
+private:
+    /** This function calculates the emissivity spectra for all library entries that have emitting
+        cells and stores them in a table shared by all execution threads, unless the memory
+        required for storing the spectra exceeds the configured limit. The calculation is
+        performed in parallel and distributed across processes. The function is called from
+        prepareForLaunch() if so requested by the configuration; see the description in the class
+        header for more information. If so requested by the configuration, the function reuses the
+        spectra calculated for the previous segment for library entries with a radiation field that
+        has hardly changed. */
+    void precalculateEmissionSpectra();
+
+public:
+
     /** This function causes the photon packet \em pp to be launched from one of the cells in the
         spatial grid using the given history index; see the description in the class header for
         more information. The photon packet's contents is fully (re-)initialized so that it is
@@ -173,7 +216,9 @@ public:
         information calculated for the "current" cell from one invocation to the next in a helper
         object allocated with thread-local storage scope. As a result, memory requirements are
         limited to storing the information for only a single cell per execution thread, and the
-        calculation is still performed only once per cell.
+        calculation is still performed only once per cell. If the emissivity spectra have been
+        precalculated by the prepareForLaunch() function, the emission spectrum for the cell is
+        obtained from the precalculated information instead.
 
         Once the emission spectrum for the current cell is known, the function randomly generates a
         wavelength either from this emission spectrum or from the configured bias wavelength
@@ -202,6 +247,12 @@ private:
     vector<int> _nv;    // the library entry index corresponding to each spatial cell (i.e. map from cells to entries)
     vector<int> _mv;    // the spatial cell indices sorted so that cells belonging to the same entry are consecutive
     vector<size_t> _Iv; // first history index allocated to each spatial cell (with extra entry at the end)
+
+    // initialized by precalculateEmissionSpectra(), or empty if the spectra are not precalculated
+    vector<int> _kv;        // the index in _evv of the library entry for each launch-order cell index, or -1
+    Array _evv;             // the emissivity spectra for each used library entry and dust medium (indexed on k,h,ell)
+    Array _Jvv;             // the radiation field for which the spectra were calculated, if kept for reuse (k,ell)
+    vector<int> _entryv;    // the library entry index for each used library entry, if kept for reuse
 };
 
 ////////////////////////////////////////////////////////////////
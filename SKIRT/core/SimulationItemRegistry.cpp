@@ -62,6 +62,7 @@
 #include "ExpDiskGeometry.hpp"
 #include "ExtinctionOnlyOptions.hpp"
 #include "ExtragalacticUnits.hpp"
+#include "FieldClusterCellLibrary.hpp"
 #include "FieldStrengthCellLibrary.hpp"
 #include "FileBand.hpp"
 #include "FileMesh.hpp"
@@ -488,6 +489,7 @@ SimulationItemRegistry::SimulationItemRegistry(string version, string format)
     ItemRegistry::add<AllCellsLibrary>();
     ItemRegistry::add<FieldStrengthCellLibrary>();
     ItemRegistry::add<TemperatureWavelengthCellLibrary>();
+    ItemRegistry::add<FieldClusterCellLibrary>();
 
     // wavelength grids
     ItemRegistry::add<WavelengthGrid>();
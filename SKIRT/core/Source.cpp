@@ -4,6 +4,7 @@
 ///////////////////////////////////////////////////////////////// */
 
 #include "Source.hpp"
+#include "PhotonPacket.hpp"
 #include "Random.hpp"
 
 //////////////////////////////////////////////////////////////////////
@@ -22,3 +23,11 @@ void Source::prepareForLaunch(double /*sourceBias*/, size_t /*firstIndex*/, size
 }
 
 //////////////////////////////////////////////////////////////////////
+
+int Source::launchWavelengthGroup(vector<PhotonPacket>& ppv, size_t historyIndex, double L) const
+{
+    launch(&ppv[0], historyIndex, L);
+    return 1;
+}
+
+//////////////////////////////////////////////////////////////////////
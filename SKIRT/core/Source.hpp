@@ -122,6 +122,21 @@ public:
         (re-)initialized so that it is ready to start its lifecycle. */
     virtual void launch(PhotonPacket* pp, size_t historyIndex, double L) const = 0;
 
+    /** This function causes a group of photon packets to be launched from the source using the
+        given history index and luminosity contribution, and returns the number of photon packets
+        actually launched. The packets in the group represent the same emission event (i.e. they
+        share the launch position, propagation direction and polarization state) but carry
+        different wavelengths, so that the geometric details of their initial paths can be
+        calculated just once for the whole group. The sum of the luminosities of all packets in the
+        group represents the specified luminosity contribution. The caller must provide a vector
+        with room for at least as many photon packets as there are discrete wavelengths in the
+        simulation.
+
+        The default implementation of this function simply launches a single photon packet through
+        the launch() function and returns 1. Subclasses may override the function for
+        oligochromatic simulations. */
+    virtual int launchWavelengthGroup(vector<PhotonPacket>& ppv, size_t historyIndex, double L) const;
+
     //======================== Other Functions =======================
 
 protected:
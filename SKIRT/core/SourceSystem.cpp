@@ -114,3 +114,23 @@ void SourceSystem::launch(PhotonPacket* pp, size_t historyIndex) const
 }
 
 //////////////////////////////////////////////////////////////////////
+
+int SourceSystem::launchWavelengthGroup(vector<PhotonPacket>& ppv, size_t historyIndex) const
+{
+    // ask the appropriate source to prepare the photon packets for launch
+    auto h = std::upper_bound(_Iv.cbegin(), _Iv.cend(), historyIndex) - _Iv.cbegin() - 1;
+    double weight = _Lv[h] / _Wv[h];
+    int numPackets = _sources[h]->launchWavelengthGroup(ppv, historyIndex, _Lpp*weight);
+
+    for (int k=0; k!=numPackets; ++k)
+    {
+        // add additional info
+        ppv[k].setPrimaryOrigin(h);
+
+        // invoke launch call-back if installed
+        if (_callback) _callback->probePhotonPacket(&ppv[k]);
+    }
+    return numPackets;
+}
+
+//////////////////////////////////////////////////////////////////////
@@ -133,6 +133,14 @@ public:
         (re-)initialized so that it is ready to start its lifecycle. */
     void launch(PhotonPacket* pp, size_t historyIndex) const;
 
+    /** This function causes a group of photon packets to be launched from one of the sources in
+        the source system using the given history index, and returns the number of photon packets
+        actually launched. The packets in the group share the same emission event but carry
+        different wavelengths; see the Source::launchWavelengthGroup() function for more
+        information. The contents of the launched photon packets is fully (re-)initialized so that
+        they are ready to start their lifecycle. */
+    int launchWavelengthGroup(vector<PhotonPacket>& ppv, size_t historyIndex) const;
+
     //======================== Data Members ========================
 
 private:
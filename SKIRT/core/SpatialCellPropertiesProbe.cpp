@@ -38,11 +38,12 @@ void SpatialCellPropertiesProbe::probeSetup()
         out.addColumn("electron number density in cell", units->unumbervolumedensity());
         out.addColumn("hydrogen number density in cell", units->unumbervolumedensity());
 
-        // write a line for each cell
+        // write a line for each cell, listed in the original cell numbering
         int numMedia = ms->numMedia();
         int numCells = grid->numCells();
-        for (int m=0; m!=numCells; ++m)
+        for (int n=0; n!=numCells; ++n)
         {
+            int m = grid->cellIndexFromOriginal(n);
             Position p = grid->centralPositionInCell(m);
             double V = ms->volume(m);
             double tau = grid->diagonal(m) * ms->opacityExt(wavelength(), m);
@@ -55,7 +56,7 @@ void SpatialCellPropertiesProbe::probeSetup()
                 if (ms->isElectrons(h)) elec += ms->numberDensity(m, h);
                 if (ms->isGas(h)) gas += ms->numberDensity(m, h);
             }
-            out.writeRow(vector<double>({ static_cast<double>(m),
+            out.writeRow(vector<double>({ static_cast<double>(n),
                                           units->olength(p.x()), units->olength(p.y()), units->olength(p.z()),
                                           units->ovolume(V), tau,
                                           units->omassvolumedensity(dust),
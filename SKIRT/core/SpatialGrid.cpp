@@ -25,6 +25,19 @@ double SpatialGrid::diagonal(int m) const
 
 //////////////////////////////////////////////////////////////////////
 
+int SpatialGrid::cellIndexFromOriginal(int n) const
+{
+    return n;
+}
+
+//////////////////////////////////////////////////////////////////////
+
+void SpatialGrid::setEmptyCells(const vector<char>& /*emptyv*/)
+{
+}
+
+//////////////////////////////////////////////////////////////////////
+
 void SpatialGrid::writeGridPlotFiles(const SimulationItem* probe) const
 {
     // For the xy plane (always)
@@ -76,6 +76,23 @@ public:
     //================ Functions that may be implemented in subclasses ===============
 
 public:
+    /** This function returns the index \f$m\f$ of the cell that has index \f$n\f$ in the
+        original numbering of the grid. Some grids offer the option to renumber their cells after
+        construction, for example along a space-filling curve, so that cells that are near each
+        other in space are also near each other in memory. Probes that output information for each
+        cell use this function to list the cells in the original numbering regardless of this
+        option. The default implementation in this class returns \f$n\f$. */
+    virtual int cellIndexFromOriginal(int n) const;
+
+    /** This function informs the grid about the cells that contain no material at all, i.e. cells
+        for which the number density of all media is zero. The vector passed as an argument has an
+        element for each cell, indexed on cell index \f$m\f$, which is nonzero if the cell is
+        empty. A grid can use this information to skip regions of empty space in a single step
+        when calculating a path for which the skipEmptyCells() flag has been enabled (see the
+        SpatialGridPath class). The default implementation in this class ignores the information,
+        so that paths always list all crossed cells. */
+    virtual void setEmptyCells(const vector<char>& emptyv);
+
     /** This function outputs text data files that allow plotting the structure of the spatial
         grid. The number of data files written depends on the dimension of the spatial grid: for
         spherical symmetry only the intersection with the xy plane is written, for axial symmetry
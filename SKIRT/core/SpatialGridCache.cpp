@@ -0,0 +1,312 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#include "SpatialGridCache.hpp"
+#include "BoolPropertyHandler.hpp"
+#include "DoubleListPropertyHandler.hpp"
+#include "DoublePropertyHandler.hpp"
+#include "EnumPropertyHandler.hpp"
+#include "FatalError.hpp"
+#include "FilePaths.hpp"
+#include "IntPropertyHandler.hpp"
+#include "ItemListPropertyHandler.hpp"
+#include "ItemPropertyHandler.hpp"
+#include "ProcessManager.hpp"
+#include "PropertyHandlerVisitor.hpp"
+#include "SchemaDef.hpp"
+#include "SimulationItemRegistry.hpp"
+#include "StringPropertyHandler.hpp"
+#include "StringUtils.hpp"
+#include "System.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <unordered_set>
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the version of the cache file format; increment when the cached data structures
+    // or the algorithms for constructing them change
+    const uint64_t formatVersion = 2;
+
+    // the file header tag and Endianness marker
+    const char fileTag[9] = "SKIRT G\n";
+    const uint64_t endianTag = 0x010203040A0BFEFF;
+
+    // the item size in the cache file format
+    const size_t itemSize = 8;
+
+    // the names of the top-level properties that do not affect the spatial grid
+    const std::unordered_set<string> ignoredProperties = {"sourceSystem", "instrumentSystem", "probeSystem",
+                                                          "numPackets"};
+
+    // 64-bit FNV-1a hash, applied to a byte sequence or to a sequence of 8-byte words
+    class Hasher
+    {
+    public:
+        void add(const char* data, size_t numBytes)
+        {
+            // process whole words for speed, then the remaining bytes
+            size_t numWords = numBytes / 8;
+            for (size_t i = 0; i != numWords; ++i)
+            {
+                uint64_t word;
+                memcpy(&word, data + 8 * i, 8);
+                _hash = (_hash ^ word) * 0x100000001b3;
+            }
+            for (size_t i = 8 * numWords; i != numBytes; ++i)
+                _hash = (_hash ^ static_cast<unsigned char>(data[i])) * 0x100000001b3;
+        }
+        void add(string text)
+        {
+            add(text.c_str(), text.size() + 1);  // include the terminating zero as a separator
+        }
+        uint64_t hash() const { return _hash; }
+
+    private:
+        uint64_t _hash{0xcbf29ce484222325};
+    };
+
+    // adds the size and the contents of the specified input file to the hash
+    void addFile(Hasher& hasher, string path)
+    {
+        std::ifstream infile = System::ifstream(path);
+        if (!infile) return;
+        vector<char> buffer(1 << 20);
+        size_t size = 0;
+        while (infile)
+        {
+            infile.read(buffer.data(), buffer.size());
+            size_t count = infile.gcount();
+            hasher.add(buffer.data(), count);
+            size += count;
+        }
+        hasher.add(std::to_string(size));
+    }
+
+    // forward declaration; see function definition at the end of this anonymous namespace
+    void addItem(Hasher& hasher, const SchemaDef* schema, const FilePaths* paths, Item* item);
+
+    // this property handler visitor adds the name and the value of each property to the hash
+    class PropertyHasher : public PropertyHandlerVisitor
+    {
+    public:
+        PropertyHasher(Hasher& hasher, const SchemaDef* schema, const FilePaths* paths)
+            : _hasher(hasher), _schema(schema), _paths(paths)
+        {}
+
+        void visitPropertyHandler(StringPropertyHandler* handler) override
+        {
+            add(handler->name(), handler->value());
+
+            // a string property may specify the name of an input file
+            if (!handler->value().empty())
+            {
+                string path = _paths->input(handler->value());
+                if (System::isFile(path)) addFile(_hasher, path);
+            }
+        }
+        void visitPropertyHandler(BoolPropertyHandler* handler) override
+        {
+            add(handler->name(), StringUtils::toString(handler->value()));
+        }
+        void visitPropertyHandler(IntPropertyHandler* handler) override
+        {
+            add(handler->name(), StringUtils::toString(handler->value()));
+        }
+        void visitPropertyHandler(EnumPropertyHandler* handler) override
+        {
+            add(handler->name(), handler->value());
+        }
+        void visitPropertyHandler(DoublePropertyHandler* handler) override
+        {
+            add(handler->name(), StringUtils::toString(handler->value(), 'e', 17));
+        }
+        void visitPropertyHandler(DoubleListPropertyHandler* handler) override
+        {
+            string value;
+            for (double x : handler->value()) value += StringUtils::toString(x, 'e', 17) + ",";
+            add(handler->name(), value);
+        }
+        void visitPropertyHandler(ItemPropertyHandler* handler) override
+        {
+            _hasher.add(handler->name());
+            if (handler->value()) addItem(_hasher, _schema, _paths, handler->value());
+        }
+        void visitPropertyHandler(ItemListPropertyHandler* handler) override
+        {
+            _hasher.add(handler->name());
+            for (Item* item : handler->value()) addItem(_hasher, _schema, _paths, item);
+        }
+
+    private:
+        void add(string name, string value)
+        {
+            _hasher.add(name);
+            _hasher.add(value);
+        }
+
+        Hasher& _hasher;
+        const SchemaDef* _schema;
+        const FilePaths* _paths;
+    };
+
+    // adds the type and the properties of the specified item and its children to the hash
+    void addItem(Hasher& hasher, const SchemaDef* schema, const FilePaths* paths, Item* item)
+    {
+        hasher.add(item->type());
+        PropertyHasher propertyHasher(hasher, schema, paths);
+        for (const string& property : schema->properties(item->type()))
+        {
+            if (item->parent() || !ignoredProperties.count(property))
+            {
+                auto handler = schema->createPropertyHandler(item, property, nullptr);
+                handler->acceptVisitor(&propertyHasher);
+            }
+        }
+        hasher.add("end");
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+SpatialGridCache::SpatialGridCache(const SimulationItem* item)
+{
+    // locate the top-level item of the simulation hierarchy
+    Item* root = const_cast<SimulationItem*>(item);
+    while (root->parent()) root = root->parent();
+
+    // calculate the key
+    Hasher hasher;
+    hasher.add(std::to_string(formatVersion));
+    auto paths = item->find<FilePaths>();
+    addItem(hasher, SimulationItemRegistry::getSchemaDef(), paths, root);
+    _key = hasher.hash();
+
+    // determine the file path
+    char keyString[17];
+    snprintf(keyString, sizeof(keyString), "%016llx", static_cast<unsigned long long>(_key));
+    _filePath = paths->outputPath() + "grid_cache_" + keyString + ".sgc";
+}
+
+////////////////////////////////////////////////////////////////////
+
+SpatialGridCache::~SpatialGridCache()
+{
+    close();
+}
+
+////////////////////////////////////////////////////////////////////
+
+bool SpatialGridCache::open()
+{
+    if (!System::isFile(_filePath)) return false;
+
+    // acquire a memory map for the file; the function returns zeros if the memory map cannot be created
+    auto map = System::acquireMemoryMap(_filePath);
+    if (!map.first) return false;
+    _begin = static_cast<const char*>(map.first);
+    _end = _begin + map.second;
+    _current = _begin;
+
+    // verify the header
+    uint64_t header[3] = {0, 0, 0};
+    if (map.second >= 4 * itemSize && !memcmp(fileTag, _begin, itemSize))
+        memcpy(header, _begin + itemSize, 3 * itemSize);
+    if (header[0] != endianTag || header[1] != formatVersion || header[2] != _key)
+    {
+        close();
+        return false;
+    }
+    _current = _begin + 4 * itemSize;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////
+
+const char* SpatialGridCache::nextSection(size_t elementSize, size_t& numElements)
+{
+    // verify the section header
+    if (!_current || _end - _current < static_cast<std::ptrdiff_t>(2 * itemSize)) return nullptr;
+    uint64_t header[2];
+    memcpy(header, _current, 2 * itemSize);
+    if (header[1] != elementSize) return nullptr;
+
+    // verify the section size, rounded up to a multiple of the item size
+    size_t numBytes = header[0] * elementSize;
+    size_t paddedBytes = (numBytes + itemSize - 1) / itemSize * itemSize;
+    if (static_cast<size_t>(_end - _current) < 2 * itemSize + paddedBytes) return nullptr;
+
+    // advance the current position
+    const char* data = _current + 2 * itemSize;
+    _current = data + paddedBytes;
+    numElements = header[0];
+    return data;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SpatialGridCache::copyData(void* target, const char* source, size_t numBytes)
+{
+    if (numBytes) memcpy(target, source, numBytes);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SpatialGridCache::close()
+{
+    if (_begin) System::releaseMemoryMap(_filePath);
+    _begin = _end = _current = nullptr;
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SpatialGridCache::appendSection(const void* data, size_t numElements, size_t elementSize)
+{
+    uint64_t header[2] = {numElements, elementSize};
+    size_t numBytes = numElements * elementSize;
+    size_t paddedBytes = (numBytes + itemSize - 1) / itemSize * itemSize;
+    size_t offset = _buffer.size();
+    _buffer.resize(offset + 2 * itemSize + paddedBytes, 0);
+    memcpy(_buffer.data() + offset, header, 2 * itemSize);
+    if (numBytes) memcpy(_buffer.data() + offset + 2 * itemSize, data, numBytes);
+}
+
+////////////////////////////////////////////////////////////////////
+
+void SpatialGridCache::save()
+{
+    if (!ProcessManager::isRoot()) return;
+
+    // write the header and the buffered sections to a temporary file; use a random name suffix so that
+    // concurrent simulations saving the same cache file do not write to the same temporary file
+    std::random_device device;
+    string tmpPath = _filePath + "." + std::to_string(device()) + std::to_string(device()) + ".tmp";
+    {
+        std::ofstream outfile(tmpPath, std::ios_base::out | std::ios_base::binary);
+        uint64_t header[3] = {endianTag, formatVersion, _key};
+        outfile.write(fileTag, itemSize);
+        outfile.write(reinterpret_cast<const char*>(header), 3 * itemSize);
+        outfile.write(_buffer.data(), _buffer.size());
+        if (!outfile)
+        {
+            outfile.close();
+            System::removeFile(tmpPath);
+            throw FATALERROR("Could not write grid cache file: " + tmpPath);
+        }
+    }
+
+    // atomically replace any existing cache file
+    if (std::rename(tmpPath.c_str(), _filePath.c_str()))
+    {
+        System::removeFile(tmpPath);
+        throw FATALERROR("Could not rename grid cache file: " + tmpPath);
+    }
+}
+
+////////////////////////////////////////////////////////////////////
@@ -0,0 +1,113 @@
+/*//////////////////////////////////////////////////////////////////
+////     The SKIRT project -- advanced radiative transfer       ////
+////       © Astronomical Observatory, Ghent University         ////
+///////////////////////////////////////////////////////////////// */
+
+#ifndef SPATIALGRIDCACHE_HPP
+#define SPATIALGRIDCACHE_HPP
+
+#include "Basics.hpp"
+#include <type_traits>
+class SimulationItem;
+
+////////////////////////////////////////////////////////////////////
+
+/** A SpatialGridCache instance manages a binary file holding the data structures of a constructed
+    spatial grid, so that a subsequent simulation with the same relevant configuration can load the
+    grid from the file rather than constructing it from scratch.
+
+    The file is named after a 64-bit key calculated from the information that may affect the
+    result of the grid construction. This includes the complete configuration of the simulation
+    with the exception of the source system, the instrument system, the probe system and the
+    number of photon packets, which by design do not influence the spatial grid. The key also
+    includes the size and the contents of any input file referenced by the configuration, and a
+    format version number that should be incremented whenever the grid data structures or the
+    construction algorithms change. The cache file is placed in the output directory without
+    output prefix, so that it can be shared between simulations that differ, for example, only
+    in their instruments or sources.
+
+    The file consists of a sequence of 8-byte items. After a header with a tag, an Endianness
+    marker, the format version and the key, the file contains a number of sections, one for each
+    vector of data saved by the client. Each section consists of the number of elements, the size
+    in bytes of a single element, and the raw element data padded to a multiple of 8 bytes. When
+    loading the cache, the file is memory-mapped and the data is copied from the map into the
+    client's vectors in the same order as it was saved.
+
+    To save a grid, the client calls the write() function for each of its data vectors, followed
+    by the save() function. To load a grid, the client calls the open() function and, if it
+    succeeds, the read() function for each of its data vectors, followed by the close() function.
+    The element types of the data vectors must be trivially copyable. */
+class SpatialGridCache final
+{
+public:
+    /** The constructor calculates the cache key for the simulation hierarchy containing the
+        specified simulation item, and determines the corresponding cache file path. */
+    explicit SpatialGridCache(const SimulationItem* item);
+
+    /** The destructor releases the memory map if it is still open. */
+    ~SpatialGridCache();
+
+    /** This function returns the path of the cache file corresponding to the configuration. */
+    string filePath() const { return _filePath; }
+
+    //============= Loading =============
+
+    /** This function attempts to open the cache file by acquiring a memory map and verifying the
+        header. It returns true if successful, and false if the file does not exist or has an
+        invalid or outdated header. */
+    bool open();
+
+    /** This function copies the next section in the opened cache file into the specified vector.
+        It returns false if the file does not contain a section with the appropriate element size
+        at this point; in that case the cache should be considered to be invalid. */
+    template<class T> bool read(vector<T>& v)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Cached type must be trivially copyable");
+        size_t n = 0;
+        const char* data = nextSection(sizeof(T), n);
+        if (!data) return false;
+        v.resize(n);
+        copyData(v.data(), data, n*sizeof(T));
+        return true;
+    }
+
+    /** This function releases the memory map for the cache file. */
+    void close();
+
+    //============= Saving =============
+
+    /** This function appends a section containing the data in the specified vector to the
+        internal buffer that will be written by the save() function. */
+    template<class T> void write(const vector<T>& v)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Cached type must be trivially copyable");
+        appendSection(v.data(), v.size(), sizeof(T));
+    }
+
+    /** This function writes the header and the buffered sections to the cache file. To avoid
+        leaving behind a partially written file, the data is first written to a temporary file,
+        which is then renamed to the cache file path. Only the root process writes the file. If an
+        error occurs, the function throws a fatal error. */
+    void save();
+
+    //============= Private helpers =============
+
+private:
+    const char* nextSection(size_t elementSize, size_t& numElements);
+    static void copyData(void* target, const char* source, size_t numBytes);
+    void appendSection(const void* data, size_t numElements, size_t elementSize);
+
+    //============= Data members =============
+
+private:
+    string _filePath;           // the path of the cache file
+    uint64_t _key{0};           // the cache key calculated from the configuration
+    const char* _begin{nullptr}; // the start of the memory map, or null if no map is open
+    const char* _end{nullptr};   // the end of the memory map
+    const char* _current{nullptr}; // the current read position in the memory map
+    vector<char> _buffer;       // the sections to be saved
+};
+
+////////////////////////////////////////////////////////////////////
+
+#endif
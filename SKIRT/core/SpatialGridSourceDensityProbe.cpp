@@ -44,13 +44,14 @@ void SpatialGridSourceDensityProbe::probeSetup()
         for (int h : hv) out.addColumn("normalized density for source " + std::to_string(h+1),
                                         "1/" + units->uvolume());
 
-        // write a line for each cell
+        // write a line for each cell, listed in the original cell numbering
         int numCells = grid->numCells();
-        for (int m=0; m!=numCells; ++m)
+        for (int n=0; n!=numCells; ++n)
         {
+            int m = grid->cellIndexFromOriginal(n);
             Position p = grid->centralPositionInCell(m);
             vector<double> row;
-            row.push_back(static_cast<double>(m));
+            row.push_back(static_cast<double>(n));
             for (auto geom : geomv) row.push_back(1./units->ovolume(1./geom->density(p)));
             out.writeRow(row);
         }
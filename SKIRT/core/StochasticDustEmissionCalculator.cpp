@@ -431,9 +431,12 @@ Array StochasticDustEmissionCalculator::emissivity(const Array& Jv) const
     // the representative grain is most certainly in equilibrium
     std::unordered_map<string,double> eqMass;
 
-    // provide room for the probabilities calculated over each of the temperature grids
+    // provide room for the probabilities calculated over each of the temperature grids;
+    // the scratch memory for the transition matrix is allocated once for each parallel execution thread
+    // and reused by subsequent invocations of this function in that thread
     Array Pv;
-    Square<double> Am(static_cast<size_t>(ceil(Tuppermax))+1);
+    thread_local Square<double> t_Am(static_cast<size_t>(ceil(Tuppermax))+1);
+    Square<double>& Am = t_Am;
 
     // loop over all representative grains (size bins) in the dust mix
     int numBins = _calculatorsA.size();
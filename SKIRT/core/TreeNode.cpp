@@ -151,6 +151,56 @@ void TreeNode::makeNeighbors(Wall wall1, TreeNode *node1, TreeNode *node2)
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // adds the leaf nodes in the hierarchy below the specified node that touch the base node
+    // to the appropriate neighbor lists of the base node
+    void addTouchingLeafNodes(TreeNode* node, TreeNode* base)
+    {
+        if (node == base) return;
+        if (node->xmin() > base->xmax() || node->xmax() < base->xmin() || node->ymin() > base->ymax()
+            || node->ymax() < base->ymin() || node->zmin() > base->zmax() || node->zmax() < base->zmin())
+            return;
+
+        if (node->isChildless())
+        {
+            // determine whether the extents overlap in each direction with a nonzero width
+            bool ox = node->xmin() < base->xmax() && node->xmax() > base->xmin();
+            bool oy = node->ymin() < base->ymax() && node->ymax() > base->ymin();
+            bool oz = node->zmin() < base->zmax() && node->zmax() > base->zmin();
+            if (oy && oz)
+            {
+                if (node->xmax() == base->xmin()) base->addNeighbor(TreeNode::BACK, node);
+                if (node->xmin() == base->xmax()) base->addNeighbor(TreeNode::FRONT, node);
+            }
+            if (ox && oz)
+            {
+                if (node->ymax() == base->ymin()) base->addNeighbor(TreeNode::LEFT, node);
+                if (node->ymin() == base->ymax()) base->addNeighbor(TreeNode::RIGHT, node);
+            }
+            if (ox && oy)
+            {
+                if (node->zmax() == base->zmin()) base->addNeighbor(TreeNode::BOTTOM, node);
+                if (node->zmin() == base->zmax()) base->addNeighbor(TreeNode::TOP, node);
+            }
+        }
+        else
+        {
+            for (auto child : node->children()) addTouchingLeafNodes(child, base);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+void TreeNode::findNeighbors(TreeNode* root)
+{
+    for (auto& neighbors : _neighbors) neighbors.clear();
+    addTouchingLeafNodes(root, this);
+}
+
+////////////////////////////////////////////////////////////////////
+
 namespace
 {
     // helper class to calculate the area of overlap between two rectangles lined-up with the coordinate axes;
@@ -133,6 +133,21 @@ public:
         (back/front, left/right, bottom/top). */
     static void makeNeighbors(Wall wall1, TreeNode* node1, TreeNode* node2);
 
+    /** This function replaces the neighbor lists of this node by the lists of leaf nodes in the
+        tree with the specified root node that border each of the walls of this node. A leaf node
+        is considered to be a neighbor at a given wall if its opposite wall lies in the same plane
+        and the two walls overlap with a nonzero area. In contrast to the addNeighbors() function,
+        which establishes the neighbor lists incrementally as nodes are being subdivided, this
+        function thus omits nodes that merely touch the wall along an edge or in a corner. Because
+        such nodes have zero overlap area, they are listed last after sorting anyway, and they are
+        never needed to locate a position just beyond the wall. The resulting neighbor lists are
+        not sorted.
+
+        Because this function changes only the neighbor lists of the receiving node, it can be
+        called for multiple nodes in parallel, provided the tree structure itself is no longer
+        being modified. */
+    void findNeighbors(TreeNode* root);
+
     /** This function sorts the neighbor lists for each wall of this node so that neighbors with a
         larger overlap area are listed first. The function should be called only after neighbors
         have been added for all nodes in the tree. */
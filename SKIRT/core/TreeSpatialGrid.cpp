@@ -7,19 +7,13 @@
 #include "Log.hpp"
 #include "Random.hpp"
 #include "SpatialGridPath.hpp"
+#include "SpatialGridCache.hpp"
 #include "SpatialGridPlotFile.hpp"
 #include "StringUtils.hpp"
 #include "TreeNode.hpp"
 
 ////////////////////////////////////////////////////////////////////
 
-TreeSpatialGrid::~TreeSpatialGrid()
-{
-    for (auto node : _nodev) delete node;
-}
-
-////////////////////////////////////////////////////////////////////
-
 void TreeSpatialGrid::setupSelfAfter()
 {
     BoxSpatialGrid::setupSelfAfter();
@@ -27,39 +21,165 @@ void TreeSpatialGrid::setupSelfAfter()
     // determine a small fraction relative to the spatial extent of the grid; used during path traversal
     _eps = 1e-12 * extent().widths().norm();
 
-    // make subclass construct the tree
+    // if requested and available, load the tree from the cache file
     Log* log = find<Log>();
+    if (cacheGrid())
+    {
+        SpatialGridCache cache(this);
+        vector<int> numSegmentsv;
+        if (cache.open() && cache.read(numSegmentsv) && cache.read(_cellindexv) && cache.read(_idv)
+            && cache.read(_childv) && cache.read(_axesv) && cache.read(_splitv) && cache.read(_cellv)
+            && cache.read(_levelv) && cache.read(_nbbeginv) && cache.read(_nbv) && cache.read(_renumberv)
+            && numSegmentsv.size() == 1)
+        {
+            // skip the random number segments that would have been used during construction, so that, if
+            // history streams are enabled, subsequent segments use the same random streams as in a simulation
+            // constructing the tree
+            for (int i=0; i!=numSegmentsv[0]; ++i) random()->startSegment();
+            log->info("Loaded the spatial tree grid from cache file " + cache.filePath());
+            logStatistics();
+            return;
+        }
+
+        // discard any data loaded from an incomplete or inconsistent cache file before constructing the tree
+        _cellindexv.clear();
+        _idv.clear();
+        _childv.clear();
+        _axesv.clear();
+        _splitv.clear();
+        _cellv.clear();
+        _levelv.clear();
+        _nbbeginv.clear();
+        _nbv.clear();
+        _renumberv.clear();
+    }
+
+    // make subclass construct the tree
     log->info("Constructing the spatial tree grid...");
-    _nodev = constructTree();
+    int firstSegment = random()->segment();
+    vector<TreeNode*> nodev = constructTree();
+    int numSegments = random()->segment() - firstSegment;
 
     // construct the vectors to help translating between node indices (leaf and nonleaf) and cell indices (leaf only)
     //  _cellindexv : cell index m corresponding to each node in nodev; -1 for nonleaf nodes
     //  _idv;       : index in nodev for each cell (i.e. leaf node); corresponds to node ID
-    int numNodes = _nodev.size();
+    int numNodes = nodev.size();
     int m = 0;
     _cellindexv.resize(numNodes, -1);
     for (int l=0; l!=numNodes; ++l)
     {
-        if (_nodev[l]->isChildless())
+        if (nodev[l]->isChildless())
         {
             _idv.push_back(l);
             _cellindexv[l] = m;
             m++;
         }
     }
+    int numCells = _idv.size();
+
+    // if requested, renumber the cells in the order of a depth-first traversal of the tree,
+    // and remember the new cell index for each cell in the original numbering
+    if (reorderCells())
+    {
+        _idv.clear();
+        vector<const TreeNode*> stack{nodev[0]};
+        while (!stack.empty())
+        {
+            const TreeNode* node = stack.back();
+            stack.pop_back();
+            if (node->isChildless())
+            {
+                _cellindexv[node->id()] = _idv.size();
+                _idv.push_back(node->id());
+            }
+            else
+            {
+                // push the children in reverse order so that they are visited in order
+                const auto& children = node->children();
+                for (auto it = children.crbegin(); it != children.crend(); ++it) stack.push_back(*it);
+            }
+        }
+        _renumberv.reserve(numCells);
+        for (int l=0; l!=numNodes; ++l) if (nodev[l]->isChildless()) _renumberv.push_back(_cellindexv[l]);
+    }
+
+    // freeze the tree structure into flat vectors indexed on node id;
+    // the children of a node always have consecutive IDs, so it suffices to remember the first one
+    _childv.resize(numNodes, -1);
+    _axesv.resize(numNodes, 0);
+    _splitv.resize(numNodes);
+    for (int l=0; l!=numNodes; ++l)
+    {
+        const TreeNode* node = nodev[l];
+        if (!node->isChildless())
+        {
+            const TreeNode* child0 = node->children()[0];
+            _childv[l] = child0->id();
+            _splitv[l] = child0->rmax();
+            _axesv[l] = (child0->xmax() != node->xmax() ? 1 : 0) + (child0->ymax() != node->ymax() ? 2 : 0)
+                        + (child0->zmax() != node->zmax() ? 4 : 0);
+        }
+    }
+
+    // freeze the cell extents and the neighbor lists into flat vectors indexed on cell index
+    _cellv.resize(numCells);
+    _levelv.resize(numCells);
+    _nbbeginv.reserve(6*numCells + 1);
+    for (int m=0; m!=numCells; ++m)
+    {
+        const TreeNode* node = nodev[_idv[m]];
+        _cellv[m] = node->extent();
+        _levelv[m] = node->level();
+        for (int wall=0; wall!=6; ++wall)
+        {
+            _nbbeginv.push_back(_nbv.size());
+            for (auto neighbor : node->neighbors(static_cast<TreeNode::Wall>(wall)))
+                _nbv.push_back(_cellindexv[neighbor->id()]);
+        }
+    }
+    _nbbeginv.push_back(_nbv.size());
+
+    // the tree nodes are no longer needed
+    for (auto node : nodev) delete node;
+    log->info("Finished construction of the spatial tree grid");
+
+    // if requested, save the tree to the cache file
+    if (cacheGrid())
+    {
+        SpatialGridCache cache(this);
+        cache.write(vector<int>{numSegments});
+        cache.write(_cellindexv);
+        cache.write(_idv);
+        cache.write(_childv);
+        cache.write(_axesv);
+        cache.write(_splitv);
+        cache.write(_cellv);
+        cache.write(_levelv);
+        cache.write(_nbbeginv);
+        cache.write(_nbv);
+        cache.write(_renumberv);
+        cache.save();
+        log->info("Saved the spatial tree grid to cache file " + cache.filePath());
+    }
+    logStatistics();
+}
+
+////////////////////////////////////////////////////////////////////
 
+void TreeSpatialGrid::logStatistics() const
+{
     // determine the number of cells at each level in the tree hierarchy
     vector<int> countv;
     int numCells = _idv.size();
     for (int m=0; m!=numCells; ++m)
     {
-        int level = nodeForCellIndex(m)->level();
+        int level = _levelv[m];
         if (level+1 > static_cast<int>(countv.size())) countv.resize(level+1);
         countv[level]++;
     }
 
     // log these statistics, including a basic histogram
-    log->info("Finished construction of the spatial tree grid");
+    Log* log = find<Log>();
     log->info("Number of cells at each level in the tree hierarchy:");
     int numLevels = countv.size();
     int maxCount = *std::max_element(countv.cbegin(), countv.cend());
@@ -85,36 +205,42 @@ int TreeSpatialGrid::numCells() const
 
 double TreeSpatialGrid::volume(int m) const
 {
-    return nodeForCellIndex(m)->volume();
+    return _cellv[m].volume();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 double TreeSpatialGrid::diagonal(int m) const
 {
-    return nodeForCellIndex(m)->diagonal();
+    return _cellv[m].diagonal();
 }
 
 ////////////////////////////////////////////////////////////////////
 
 int TreeSpatialGrid::cellIndex(Position bfr) const
 {
-    const TreeNode* node = root()->leafChild(bfr);
-    return node ? cellIndexForNode(node) : -1;
+    return leafCell(bfr);
+}
+
+////////////////////////////////////////////////////////////////////
+
+int TreeSpatialGrid::cellIndexFromOriginal(int n) const
+{
+    return _renumberv.empty() ? n : _renumberv[n];
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Position TreeSpatialGrid::centralPositionInCell(int m) const
 {
-    return Position(nodeForCellIndex(m)->extent().center());
+    return Position(_cellv[m].center());
 }
 
 ////////////////////////////////////////////////////////////////////
 
 Position TreeSpatialGrid::randomPositionInCell(int m) const
 {
-    return random()->position(nodeForCellIndex(m)->extent());
+    return random()->position(_cellv[m]);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -124,10 +250,10 @@ void TreeSpatialGrid::path(SpatialGridPath* path) const
     // if the photon packet starts outside the dust grid, move it into the first grid cell that it will pass
     Position bfr = path->moveInside(extent(), _eps);
 
-    // get the node containing the current location;
+    // get the cell containing the current location;
     // if the position is not inside the grid, return an empty path
-    const TreeNode* node = root()->leafChild(bfr);
-    if (!node) return path->clear();
+    int m = leafCell(bfr);
+    if (m < 0) return path->clear();
 
     // get the starting point and direction
     double x,y,z;
@@ -135,12 +261,20 @@ void TreeSpatialGrid::path(SpatialGridPath* path) const
     double kx,ky,kz;
     path->direction().cartesian(kx,ky,kz);
 
-    // loop over nodes/path segments until we leave the grid
-    while (node)
+    // determine whether we can skip density-free subtrees
+    bool skip = path->skipEmptyCells() && !_emptyv.empty();
+
+    // loop over cells/path segments until we leave the grid
+    while (m >= 0)
     {
-        double xnext = (kx<0.0) ? node->xmin() : node->xmax();
-        double ynext = (ky<0.0) ? node->ymin() : node->ymax();
-        double znext = (kz<0.0) ? node->zmin() : node->zmax();
+        // if the current cell is empty and we're allowed to skip, cross the largest empty node containing it instead
+        bool empty = skip && _emptyv[_idv[m]];
+        Box node;
+        if (empty) node = emptyNodeExtent(Vec(x,y,z));
+        const Box& cell = empty ? node : _cellv[m];
+        double xnext = (kx<0.0) ? cell.xmin() : cell.xmax();
+        double ynext = (ky<0.0) ? cell.ymin() : cell.ymax();
+        double znext = (kz<0.0) ? cell.zmin() : cell.zmax();
         double dsx = (fabs(kx)>1e-15) ? (xnext-x)/kx : DBL_MAX;
         double dsy = (fabs(ky)>1e-15) ? (ynext-y)/ky : DBL_MAX;
         double dsz = (fabs(kz)>1e-15) ? (znext-z)/kz : DBL_MAX;
@@ -162,35 +296,37 @@ void TreeSpatialGrid::path(SpatialGridPath* path) const
             ds = dsz;
             wall = (kz<0.0) ? TreeNode::BOTTOM : TreeNode::TOP;
         }
-        path->addSegment(cellIndexForNode(node), ds);
+        if (empty) path->addEmptySegment(ds);
+        else path->addSegment(m, ds);
+        if (path->atSegmentLimit()) return;
         x += (ds+_eps)*kx;
         y += (ds+_eps)*ky;
         z += (ds+_eps)*kz;
 
-        // attempt to find the new node among the neighbors of the current node;
+        // attempt to find the new cell among the neighbors of the current cell;
         // this should not fail unless the new location is outside the grid,
         // however on rare occasions it fails due to rounding errors (e.g. in a corner),
-        // thus we use top-down search as a fall-back
-        const TreeNode* oldnode = node;
-        node = node->neighbor(wall, Vec(x,y,z));
-        if (!node) node = root()->leafChild(Vec(x,y,z));
+        // thus we use top-down search as a fall-back; after crossing an empty node we always use top-down search
+        int oldm = m;
+        m = empty ? -1 : neighborCell(m, wall, Vec(x,y,z));
+        if (m < 0) m = leafCell(Vec(x,y,z));
 
-        // if we're stuck in the same node...
-        if (node==oldnode)
+        // if we're stuck in the same cell...
+        if (m==oldm)
         {
             // try to escape by advancing the position to the next representable coordinates
             find<Log>()->warning("Photon packet seems stuck in spatial cell "
-                                 + std::to_string(node->id()) + " -- escaping");
+                                 + std::to_string(_idv[m]) + " -- escaping");
             x = std::nextafter(x, (kx<0.0) ? -DBL_MAX : DBL_MAX);
             y = std::nextafter(y, (ky<0.0) ? -DBL_MAX : DBL_MAX);
             z = std::nextafter(z, (kz<0.0) ? -DBL_MAX : DBL_MAX);
-            node = root()->leafChild(Vec(x,y,z));
+            m = leafCell(Vec(x,y,z));
 
             // if that didn't work, terminate the path
-            if (node==oldnode)
+            if (m==oldm)
             {
                 find<Log>()->warning("Photon packet is stuck in spatial cell "
-                                     + std::to_string(node->id()) + " -- terminating this path");
+                                     + std::to_string(_idv[m]) + " -- terminating this path");
                 break;
             }
         }
@@ -199,17 +335,47 @@ void TreeSpatialGrid::path(SpatialGridPath* path) const
 
 ////////////////////////////////////////////////////////////////////
 
+void TreeSpatialGrid::setEmptyCells(const vector<char>& emptyv)
+{
+    // flag the leaf nodes, and then the nonleaf nodes in order of decreasing id;
+    // because the children of a node always have a larger id than the node itself,
+    // the flags for all children have been determined by the time we reach their parent
+    int numNodes = _childv.size();
+    _emptyv.resize(numNodes);
+    for (int l=numNodes-1; l>=0; --l)
+    {
+        if (_childv[l] < 0) _emptyv[l] = emptyv[_cellindexv[l]];
+        else
+        {
+            int numChildren = 1 << ((_axesv[l]&1) + ((_axesv[l]>>1)&1) + ((_axesv[l]>>2)&1));
+            _emptyv[l] = 1;
+            for (int c=0; c!=numChildren; ++c) if (!_emptyv[_childv[l]+c]) _emptyv[l] = 0;
+        }
+    }
+
+    // log the fraction of the grid volume that can be skipped
+    double emptyVolume = 0.;
+    int numCells = _idv.size();
+    for (int m=0; m!=numCells; ++m) if (emptyv[m]) emptyVolume += _cellv[m].volume();
+    find<Log>()->info("Path traversal can skip " + StringUtils::toString(100.*emptyVolume/extent().volume(), 'f', 1)
+                      + "% of the spatial tree grid volume without material");
+}
+
+////////////////////////////////////////////////////////////////////
+
 namespace
 {
     // this function writes a "0" for a leaf node or a "1" for a nonleaf node
     // followed by the recursive topological representation of its children
-    void writeTopologyForNode(TreeNode* node, TextOutFile* outfile)
+    void writeTopologyForNode(int l, const vector<int>& childv, const vector<unsigned char>& axesv,
+                              TextOutFile* outfile)
     {
-        if (node->isChildless()) outfile->writeLine("0");
+        if (childv[l] < 0) outfile->writeLine("0");
         else
         {
             outfile->writeLine("1");
-            for (auto child : node->children()) writeTopologyForNode(child, outfile);
+            int numChildren = 1 << ((axesv[l]&1) + ((axesv[l]>>1)&1) + ((axesv[l]>>2)&1));
+            for (int c=0; c!=numChildren; ++c) writeTopologyForNode(childv[l]+c, childv, axesv, outfile);
         }
     }
 }
@@ -219,8 +385,9 @@ namespace
 void TreeSpatialGrid::writeTopology(TextOutFile* outfile) const
 {
     outfile->writeLine("# Topology for tree spatial grid with " + std::to_string(numCells()) + " cells");
-    outfile->writeLine(std::to_string(root()->children().size()));  // zero if the root node is not subdivided
-    writeTopologyForNode(root(), outfile);
+    int numChildren = 1 << ((_axesv[0]&1) + ((_axesv[0]>>1)&1) + ((_axesv[0]>>2)&1));
+    outfile->writeLine(std::to_string(_childv[0] < 0 ? 0 : numChildren));  // zero if the root node is not subdivided
+    writeTopologyForNode(0, _childv, _axesv, outfile);
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -232,10 +399,10 @@ void TreeSpatialGrid::write_xy(SpatialGridPlotFile* outfile) const
     int nCells = numCells();
     for (int m=0; m!=nCells; ++m)
     {
-        TreeNode* node = nodeForCellIndex(m);
-        if (fabs(node->zmin()) < 1e-8*extent().zwidth())
+        const Box& cell = _cellv[m];
+        if (fabs(cell.zmin()) < 1e-8*extent().zwidth())
         {
-            outfile->writeRectangle(node->xmin(), node->ymin(), node->xmax(), node->ymax());
+            outfile->writeRectangle(cell.xmin(), cell.ymin(), cell.xmax(), cell.ymax());
         }
     }
 }
@@ -249,10 +416,10 @@ void TreeSpatialGrid::write_xz(SpatialGridPlotFile* outfile) const
     int nCells = numCells();
     for (int m=0; m!=nCells; ++m)
     {
-        TreeNode* node = nodeForCellIndex(m);
-        if (fabs(node->ymin()) < 1e-8*extent().ywidth())
+        const Box& cell = _cellv[m];
+        if (fabs(cell.ymin()) < 1e-8*extent().ywidth())
         {
-            outfile->writeRectangle(node->xmin(), node->zmin(), node->xmax(), node->zmax());
+            outfile->writeRectangle(cell.xmin(), cell.zmin(), cell.xmax(), cell.zmax());
         }
     }
 }
@@ -266,10 +433,10 @@ void TreeSpatialGrid::write_yz(SpatialGridPlotFile* outfile) const
     int nCells = numCells();
     for (int m=0; m!=nCells; ++m)
     {
-        TreeNode* node = nodeForCellIndex(m);
-        if (fabs(node->xmin()) < 1e-8*extent().xwidth())
+        const Box& cell = _cellv[m];
+        if (fabs(cell.xmin()) < 1e-8*extent().xwidth())
         {
-            outfile->writeRectangle(node->ymin(), node->zmin(), node->ymax(), node->zmax());
+            outfile->writeRectangle(cell.ymin(), cell.zmin(), cell.ymax(), cell.zmax());
         }
     }
 }
@@ -283,7 +450,7 @@ void TreeSpatialGrid::write_xyz(SpatialGridPlotFile* outfile) const
     int nCells = numCells();
     for (int m=0; m!=nCells; ++m)
     {
-        int level = nodeForCellIndex(m)->level();
+        int level = _levelv[m];
         if (level+1 > static_cast<int>(countv.size())) countv.resize(level+1);
         countv[level]++;
     }
@@ -306,31 +473,94 @@ void TreeSpatialGrid::write_xyz(SpatialGridPlotFile* outfile) const
     // output all leaf cells up to a certain level
     for (int m=0; m!=nCells; ++m)
     {
-        TreeNode* node = nodeForCellIndex(m);
-        if (node->level() <= highestWriteLevel)
-            outfile->writeCube(node->xmin(), node->ymin(), node->zmin(), node->xmax(), node->ymax(), node->zmax());
+        const Box& cell = _cellv[m];
+        if (_levelv[m] <= highestWriteLevel)
+            outfile->writeCube(cell.xmin(), cell.ymin(), cell.zmin(), cell.xmax(), cell.ymax(), cell.zmax());
     }
 }
 
 ////////////////////////////////////////////////////////////////////
 
-TreeNode* TreeSpatialGrid::root() const
+int TreeSpatialGrid::childNode(int l, Vec r) const
 {
-    return _nodev[0];
+    // the children are numbered by setting a bit for each split axis (in x, y, z order)
+    // if the position lies beyond the split point along that axis
+    int axes = _axesv[l];
+    const Vec& split = _splitv[l];
+    int c = 0;
+    int bit = 1;
+    if (axes & 1)
+    {
+        if (r.x() >= split.x()) c |= bit;
+        bit <<= 1;
+    }
+    if (axes & 2)
+    {
+        if (r.y() >= split.y()) c |= bit;
+        bit <<= 1;
+    }
+    if (axes & 4)
+    {
+        if (r.z() >= split.z()) c |= bit;
+    }
+    return _childv[l] + c;
 }
 
 ////////////////////////////////////////////////////////////////////
 
-TreeNode* TreeSpatialGrid::nodeForCellIndex(int m) const
+int TreeSpatialGrid::leafCell(Vec r) const
 {
-    return _nodev[_idv[m]];
+    if (!extent().contains(r)) return -1;
+
+    int l = 0;
+    while (_childv[l] >= 0) l = childNode(l, r);
+    return _cellindexv[l];
 }
 
 ////////////////////////////////////////////////////////////////////
 
-int TreeSpatialGrid::cellIndexForNode(const TreeNode* node) const
+Box TreeSpatialGrid::emptyNodeExtent(Vec r) const
 {
-    return _cellindexv[node->id()];
+    // descend the tree until we reach an empty node, narrowing the extent of the current node along the way
+    double xmin, ymin, zmin, xmax, ymax, zmax;
+    extent().extent(xmin, ymin, zmin, xmax, ymax, zmax);
+    int l = 0;
+    while (!_emptyv[l] && _childv[l] >= 0)
+    {
+        int axes = _axesv[l];
+        const Vec& split = _splitv[l];
+        if (axes & 1)
+        {
+            if (r.x() >= split.x()) xmin = split.x();
+            else xmax = split.x();
+        }
+        if (axes & 2)
+        {
+            if (r.y() >= split.y()) ymin = split.y();
+            else ymax = split.y();
+        }
+        if (axes & 4)
+        {
+            if (r.z() >= split.z()) zmin = split.z();
+            else zmax = split.z();
+        }
+        l = childNode(l, r);
+    }
+    return Box(xmin, ymin, zmin, xmax, ymax, zmax);
+}
+
+////////////////////////////////////////////////////////////////////
+
+int TreeSpatialGrid::neighborCell(int m, int wall, Vec r) const
+{
+    int index = m*6 + wall;
+    int end = _nbbeginv[index+1];
+    for (int i = _nbbeginv[index]; i!=end; ++i)
+    {
+        int n = _nbv[i];
+        if (_cellv[n].contains(r)) return n;
+    }
+    return -1;  // specified position is not inside any of the neighbors
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -27,13 +27,39 @@ class TreeNode;
 class TreeSpatialGrid : public BoxSpatialGrid
 {
     ITEM_ABSTRACT(TreeSpatialGrid, BoxSpatialGrid, "a hierarchical tree spatial grid")
+
+    PROPERTY_BOOL(cacheGrid, "cache the constructed grid in a file for use by subsequent simulations")
+        ATTRIBUTE_DEFAULT_VALUE(cacheGrid, "false")
+        ATTRIBUTE_DISPLAYED_IF(cacheGrid, "Level3")
+
+    PROPERTY_BOOL(reorderCells, "renumber the cells along a space-filling curve to improve memory locality")
+        ATTRIBUTE_DEFAULT_VALUE(reorderCells, "false")
+        ATTRIBUTE_DISPLAYED_IF(reorderCells, "Level3")
+
     ITEM_END()
 
-    //============= Construction - Setup - Destruction =============
+    /** \fn cacheGrid
+        If this flag is enabled, the data structures describing the constructed tree are saved in a
+        binary cache file in the output directory. A subsequent simulation with the same relevant
+        configuration loads the tree from this file rather than constructing it again, which may
+        save substantial run time for simulations that differ, for example, only in their
+        instruments or sources. The cache file name is derived from a key calculated from all
+        information that might affect the tree construction, including the contents of any input
+        files, as described for the SpatialGridCache class. Obsolete cache files are not removed
+        automatically. */
+
+    /** \fn reorderCells
+        If this flag is enabled, the cells (leaf nodes) are numbered in the order of a depth-first
+        traversal of the tree rather than in the order of their node IDs, which reflects the
+        breadth-first order in which the nodes were created. For an octtree, the depth-first order
+        traces a Morton (Z-order) space-filling curve, so that cells that are near each other in
+        space are usually also near each other in the cell numbering. Because the medium system
+        stores the medium state and the radiation field in arrays indexed on cell number, this
+        improves the memory locality of the operations performed along a photon packet path, which
+        may noticeably reduce run time for large grids. The per-cell output of probes is still
+        listed in the original cell numbering (see the cellIndexFromOriginal() function). */
 
-public:
-    /** The destructor deletes all tree nodes created during setup. */
-    ~TreeSpatialGrid();
+    //============= Construction - Setup - Destruction =============
 
 protected:
     /** This function invokes the constructTree() function, to be implemented by a subclass,
@@ -46,8 +72,24 @@ protected:
         contains the node IDs of all leaf nodes, i.e. all nodes corresponding to the actual spatial
         cells. Conversely, the function also creates a vector with the cell indices of all the
         nodes, i.e. the rank \f$m\f$ of the node in the ID vector if the node is a leaf, and the
-        number -1 if the node is not a leaf (and hence not a spatial cell). Finally, the function
-        logs some details on the number of cells in the tree. */
+        number -1 if the node is not a leaf (and hence not a spatial cell). If the \em
+        reorderCells flag is enabled, the cell indices are assigned in depth-first order, and the
+        function remembers the mapping from the original numbering in order of node ID.
+
+        The function then freezes the tree into a compact, pointer-free representation consisting
+        of a few flat arrays: for each node, the ID of its first child (the children of a node
+        always have consecutive IDs), the coordinate axes split by its children, and the split
+        point; for each cell, its extent and level; and for all cells, the neighbor lists in
+        compressed sparse row format, listing the cell indices of the neighbors at each of the six
+        cell walls. Once these arrays have been constructed, the TreeNode objects are no longer
+        needed and are deleted, which substantially reduces the memory footprint of the grid and
+        improves the data locality of the path() and cellIndex() functions.
+
+        If the \em cacheGrid flag is enabled and a valid cache file for the current configuration
+        exists, the function loads the flat arrays from the cache file instead of constructing the
+        tree. Otherwise, the function constructs the tree as described above and saves the flat
+        arrays to a new cache file. Finally, the function logs some details on the number of cells
+        in the tree. */
     void setupSelfAfter() override;
 
     /** This function must be implemented in a subclass. It constructs the hierarchical tree and
@@ -90,6 +132,11 @@ public:
         it is a leaf node that corresponds to an actual spatial cell. */
     int cellIndex(Position bfr) const override;
 
+    /** This function returns the index of the cell that has index \f$n\f$ in the original
+        numbering, i.e. in order of node ID. If the \em reorderCells flag is disabled, the function
+        simply returns \f$n\f$. */
+    int cellIndexFromOriginal(int n) const override;
+
     /** This function returns the central location of the cell with index \f$m\f$. For a tree grid,
         it determines the node ID corresponding to the cell index \f$m\f$, and then calculates the
         central position in that node through \f[ \begin{split} x &= x_{\text{min}} + \frac12\,
@@ -121,9 +168,22 @@ public:
         repeat this exercise. This loop is terminated when the next position is outside the grid.
 
         To determine the cell index of the "next cell" in this algorithm, the function uses the
-        neighbor lists constructed for each tree node during setup. */
+        neighbor lists constructed for each cell during setup.
+
+        If the grid has been informed about its empty cells (see setEmptyCells()) and the path
+        allows skipping empty cells, the function handles a current position inside an empty cell
+        differently. It locates the largest empty node containing the position, i.e. the root of
+        the density-free subtree, and moves the position across that node in a single step. The
+        corresponding path length is added as a segment with cell index -1, merged with any
+        preceding segment outside of the grid or in empty space. The next cell is then found
+        through a top-down search in the tree. */
     void path(SpatialGridPath* path) const override;
 
+    /** This function remembers which cells contain no material, and propagates this information
+        up the tree so that each node is flagged as empty if all of its descendants are empty. The
+        path() function uses these flags to cross density-free subtrees in a single step. */
+    void setEmptyCells(const vector<char>& emptyv) override;
+
     /** This function writes the topology of the tree to the specified text file in a simple,
         proprietary format. After a brief descriptive header, it writes lines that each contain
         just a single integer number. The first line specifies the number of children for each
@@ -152,28 +212,54 @@ protected:
     void write_xyz(SpatialGridPlotFile* outfile) const override;
 
 private:
-    /** This function returns a pointer to the root node of the tree. */
-    TreeNode* root() const;
-
-    /** This function returns a pointer to the node corresponding to cell index \f$m\f$. It just
-        reads the node ID of the \f$m\f$'th leaf cell from the precalculated ID vector and returns
-        the corresponding pointer of the tree vector. */
-    TreeNode* nodeForCellIndex(int m) const;
-
-    /** This function returns the cell index \f$m\f$ of a node in the tree. It just obtains the
-        node ID from the node and determines the corresponding cell index from the precalculated
-        cell index vector. */
-    int cellIndexForNode(const TreeNode* node) const;
+    /** This function logs the number of cells at each level in the tree hierarchy, including a
+        basic histogram. */
+    void logStatistics() const;
+
+    /** This function returns the ID of the child of the nonleaf node with ID \f$l\f$ that
+        contains the position \f${\bf{r}}\f$, assuming that the node itself contains the
+        position. */
+    int childNode(int l, Vec r) const;
+
+    /** This function returns the index of the cell that contains the position \f${\bf{r}}\f$, or
+        -1 if the position is outside of the grid. The search starts at the root node and descends
+        the tree using the precalculated child and split point vectors. */
+    int leafCell(Vec r) const;
+
+    /** This function returns the index of the cell neighboring the cell with index \f$m\f$ at
+        the given wall (specified as a TreeNode::Wall value) that contains the position
+        \f${\bf{r}}\f$, or -1 if the position is not inside any of these neighbors. */
+    int neighborCell(int m, int wall, Vec r) const;
+
+    /** This function returns the extent of the largest node flagged as empty that contains the
+        position \f${\bf{r}}\f$, assuming that the leaf node containing the position is empty.
+        The search starts at the root node and descends the tree until it encounters an empty
+        node. */
+    Box emptyNodeExtent(Vec r) const;
 
     //======================== Data Members ========================
 
 private:
     // data members initialized during setup
     double _eps{0.};            // a small fraction relative to the spatial extent of the grid
-    vector<TreeNode*> _nodev;   // list of all nodes in the tree; holds ownership; first item is root node
-                                // node id in each node corresponds to index in this vector
-    vector<int> _cellindexv;    // cell index m corresponding to each node in nodev; -1 for nonleaf nodes
-    vector<int> _idv;           // node id (or equivalently, index in nodev) for each cell (i.e. leaf node)
+    vector<int> _cellindexv;    // cell index m corresponding to each node; -1 for nonleaf nodes
+    vector<int> _idv;           // node id for each cell (i.e. leaf node)
+    vector<int> _renumberv;     // cell index for each cell in the original numbering; empty if not reordered
+
+    // compact tree representation indexed on node id; the root node has id 0
+    vector<int> _childv;        // id of the first child for each node; -1 for leaf nodes
+    vector<unsigned char> _axesv; // bit mask indicating the axes split by the children (x=1, y=2, z=4); 0 for leaf
+    vector<Vec> _splitv;        // split point for each nonleaf node, i.e. the upper corner of its first child
+
+    // compact cell representation indexed on cell index
+    vector<Box> _cellv;         // extent of each cell
+    vector<int> _levelv;        // level in the tree hierarchy of each cell
+    vector<int> _nbbeginv;      // index in _nbv of the first neighbor for each cell and wall (at m*6+wall);
+                                // the vector has an extra element at the end
+    vector<int> _nbv;           // cell indices of the neighbors for all cells and walls
+
+    // data members initialized by setEmptyCells(), if it is called
+    vector<char> _emptyv;       // nonzero for each node that contains no material, indexed on node id
 };
 
 //////////////////////////////////////////////////////////////////////
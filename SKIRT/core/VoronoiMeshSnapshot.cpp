@@ -19,6 +19,7 @@
 #include "HDF5InFile.hpp"
 #include "Units.hpp"
 #include "voro_compute.hh"
+#include <cstring>
 
 ////////////////////////////////////////////////////////////////////
 
@@ -37,10 +38,16 @@ namespace
         void write(double v) { _data.push_back(v); }
         void write(Vec v) { _data.insert(_data.end(), {v.x(), v.y(), v.z()}); }
         void write(Box v) { _data.insert(_data.end(), {v.xmin(), v.ymin(), v.zmin(), v.xmax(), v.ymax(), v.zmax()}); }
+        // packs two 4-byte integers in each 8-byte item to reduce communication volume;
+        // the bit patterns are copied with memcpy so that they are never interpreted as floating point values
         void write(const vector<int>& v)
         {
-            _data.push_back(v.size());
-            _data.insert(_data.end(), v.begin(), v.end());
+            static_assert(sizeof(double) == 2*sizeof(int), "Cannot pack two integers in a double");
+            int n = v.size();
+            _data.push_back(n);
+            size_t offset = _data.size();
+            _data.resize(offset + (n+1)/2);
+            if (n) memcpy(_data.data()+offset, v.data(), n*sizeof(int));
         }
     };
 
@@ -60,9 +67,9 @@ namespace
         void read(vector<int>& v)
         {
             int n = *_data++;
-            v.clear();
-            v.reserve(n);
-            for (int i=0; i!=n; ++i) v.push_back(*_data++);
+            v.resize(n);
+            if (n) memcpy(v.data(), _data, n*sizeof(int));
+            _data += (n+1)/2;
         }
     };
 }
@@ -139,6 +146,9 @@ public:
     // returns a list of neighboring cell/site ids
     const vector<int>& neighbors() { return _neighbors; }
 
+    // releases the memory held by the list of neighboring cell/site ids
+    void clearNeighbors() { vector<int>().swap(_neighbors); }
+
     // returns the cell/site user properties, if any
     const Array& properties() { return _properties; }
 
@@ -312,6 +322,51 @@ public:
 
 ////////////////////////////////////////////////////////////////////
 
+namespace
+{
+    // maximum number of Voronoi sites processed between two invocations of infoIfElapsed()
+    const int logProgressChunkSize = 1000;
+
+    // computes the Voronoi cell for each site in the specified container and passes the site ID and the computed
+    // cell to the specified function; the work is distributed over execution threads and processes in chunks of
+    // consecutive container blocks, so that each chunk visits just the sites in its own blocks
+    void computeCells(voro::container& vcon, Log* log, std::function<void(int m, voro::cell& vcell)> consume)
+    {
+        auto parallel = log->find<ParallelFactory>()->parallelDistributed();
+        parallel->call(vcon.nxyz, [&vcon, log, &consume](size_t firstIndex, size_t numIndices)
+        {
+            // allocate space for the cell calculator object and for the resulting cell info
+            voro::compute vcompute(vcon);
+            voro::cell vcell;
+
+            // use a loop object to identify the site being computed; we set its public position members directly
+            voro::loop vloop(vcon);
+            int numDone = 0;
+            for (size_t ijk=firstIndex; ijk!=firstIndex+numIndices; ++ijk)
+            {
+                vloop.ijk = ijk;
+                vloop.i = ijk % vcon.nx;
+                vloop.j = (ijk / vcon.nx) % vcon.ny;
+                vloop.k = ijk / vcon.nxy;
+                for (vloop.q = 0; vloop.q != vcon.co[ijk]; ++vloop.q)
+                {
+                    // compute the cell and pass it on
+                    bool ok = vcompute.compute_cell(vcell, vloop);
+                    if (!ok) throw FATALERROR("Can't compute Voronoi cell");
+                    consume(vloop.pid(), vcell);
+
+                    // log message if the minimum time has elapsed
+                    numDone = (numDone+1)%logProgressChunkSize;
+                    if (numDone==0) log->infoIfElapsed("Computed Voronoi cells: ", logProgressChunkSize);
+                }
+            }
+            if (numDone>0) log->infoIfElapsed("Computed Voronoi cells: ", numDone);
+        });
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
 VoronoiMeshSnapshot::VoronoiMeshSnapshot()
 {
 }
@@ -464,9 +519,6 @@ VoronoiMeshSnapshot::VoronoiMeshSnapshot(const SimulationItem* item, const Box&
 
 void VoronoiMeshSnapshot::buildMesh(bool relax)
 {
-    // maximum number of Voronoi sites processed between two invocations of infoIfElapsed()
-    const int logProgressChunkSize = 1000;
-
     // remove sites that lie outside of the domain
     int numOutside = 0;
     for (int m = _cells.size()-1; m >= 0; --m)
@@ -539,36 +591,9 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
         // and store the cell's centroid (relative to the site position) as the relaxation offset
         log()->info("Relaxing Voronoi tessellation with " + std::to_string(numCells) + " cells");
         log()->infoSetElapsed(numCells);
-        auto parallel = log()->find<ParallelFactory>()->parallelDistributed();
-        parallel->call(numCells, [this, &vcon, &offsets](size_t firstIndex, size_t numIndices)
+        computeCells(vcon, log(), [&offsets](int m, voro::cell& vcell)
         {
-            // allocate space for the cell calculator object and for the resulting cell info
-            voro::compute vcompute(vcon);
-            voro::cell vcell;
-
-            // loop over all cells and work on the ones that have a particle index in our dedicated range
-            // (we cannot access cells in the container based on cell index m without building an extra data structure)
-            int numDone = 0;
-            voro::loop vloop(vcon);
-            if (vloop.start()) do
-            {
-                size_t m = vloop.pid();
-                if (m >= firstIndex && m < firstIndex+numIndices)
-                {
-                    // compute the cell
-                    bool ok = vcompute.compute_cell(vcell, vloop);
-                    if (!ok) throw FATALERROR("Can't compute Voronoi cell");
-
-                    // store the cell's centroid as relaxation offset
-                    vcell.centroid(offsets(m,0), offsets(m,1), offsets(m,2));
-
-                    // log message if the minimum time has elapsed
-                    numDone = (numDone+1)%logProgressChunkSize;
-                    if (numDone==0) log()->infoIfElapsed("Computed Voronoi cells: ", logProgressChunkSize);
-                }
-            }
-            while (vloop.inc());
-            if (numDone>0) log()->infoIfElapsed("Computed Voronoi cells: ", numDone);
+            vcell.centroid(offsets(m,0), offsets(m,1), offsets(m,2));
         });
 
         // communicate the calculated offsets between parallel processes, if needed, and apply them to the cells
@@ -590,36 +615,9 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
     //   - extract and copy the relevant information to the cell object with the corresponding index in our vector
     log()->info("Constructing Voronoi tessellation with " + std::to_string(numCells) + " cells");
     log()->infoSetElapsed(numCells);
-    auto parallel = log()->find<ParallelFactory>()->parallelDistributed();
-    parallel->call(numCells, [this, &vcon](size_t firstIndex, size_t numIndices)
+    computeCells(vcon, log(), [this](int m, voro::cell& vcell)
     {
-        // allocate space for the cell calculator object and for the resulting cell info
-        voro::compute vcompute(vcon);
-        voro::cell vcell;
-
-        // loop over all cells and work on the ones that have a particle index in our dedicated range
-        // (we cannot access cells in the container based on cell index m without building an extra data structure)
-        int numDone = 0;
-        voro::loop vloop(vcon);
-        if (vloop.start()) do
-        {
-            size_t m = vloop.pid();
-            if (m >= firstIndex && m < firstIndex+numIndices)
-            {
-                // compute the cell
-                bool ok = vcompute.compute_cell(vcell, vloop);
-                if (!ok) throw FATALERROR("Can't compute Voronoi cell");
-
-                // copy all relevant information to the cell object that will stay around
-                _cells[m]->init(vcell);
-
-                // log message if the minimum time has elapsed
-                numDone = (numDone+1)%logProgressChunkSize;
-                if (numDone==0) log()->infoIfElapsed("Computed Voronoi cells: ", logProgressChunkSize);
-            }
-        }
-        while (vloop.inc());
-        if (numDone>0) log()->infoIfElapsed("Computed Voronoi cells: ", numDone);
+        _cells[m]->init(vcell);
     });
 
     // communicate the calculated cell information between parallel processes, if needed
@@ -639,13 +637,39 @@ void VoronoiMeshSnapshot::buildMesh(bool relax)
         ProcessManager::broadcastAllToAll(producer, consumer);
     }
 
+    // copy the neighbor lists into a single contiguous array, and precompute the bisecting plane between each
+    // site and its neighbor, so that the path() function does not need to recalculate it for every step
+    _nbbeginv.resize(numCells+1);
+    _nbbeginv[0] = 0;
+    for (int m=0; m!=numCells; ++m) _nbbeginv[m+1] = _nbbeginv[m] + _cells[m]->neighbors().size();
+    _nbv.resize(_nbbeginv[numCells]);
+    _facev.resize(_nbbeginv[numCells]);
+    for (int m=0; m!=numCells; ++m)
+    {
+        Vec pr = _cells[m]->position();
+        int i = _nbbeginv[m];
+        for (int mi : _cells[m]->neighbors())
+        {
+            _nbv[i] = mi;
+            if (mi >= 0)
+            {
+                Vec pi = _cells[mi]->position();
+                Vec n = pi - pr;
+                _facev[i].n = n;
+                _facev[i].d = Vec::dot(n, 0.5*(pi+pr));
+            }
+            i++;
+        }
+        _cells[m]->clearNeighbors();
+    }
+
     // compile neighbor statistics
     int minNeighbors = INT_MAX;
     int maxNeighbors = 0;
     int64_t totNeighbors = 0;
     for (int m=0; m<numCells; m++)
     {
-        int ns = _cells[m]->neighbors().size();
+        int ns = _nbbeginv[m+1] - _nbbeginv[m];
         totNeighbors += ns;
         minNeighbors = min(minNeighbors, ns);
         maxNeighbors = max(maxNeighbors, ns);
@@ -743,11 +767,12 @@ void VoronoiMeshSnapshot::buildSearch()
 
 ////////////////////////////////////////////////////////////////////
 
-bool VoronoiMeshSnapshot::isPointClosestTo(Vec r, int m, const vector<int>& ids) const
+bool VoronoiMeshSnapshot::isPointClosestTo(Vec r, int m) const
 {
     double target = _cells[m]->squaredDistanceTo(r);
-    for (int id : ids)
+    for (int i=_nbbeginv[m]; i!=_nbbeginv[m+1]; ++i)
     {
+        int id = _nbv[i];
         if (id>=0 && _cells[id]->squaredDistanceTo(r) < target) return false;
     }
     return true;
@@ -881,13 +906,12 @@ Position VoronoiMeshSnapshot::generatePosition(int m) const
 {
     // get loop-invariant information about the cell
     const Box& box = _cells[m]->extent();
-    const vector<int>& neighbors = _cells[m]->neighbors();
 
     // generate random points in the enclosing box until one happens to be inside the cell
     for (int i=0; i<10000; i++)
     {
         Position r = random()->position(box);
-        if (isPointClosestTo(r, m, neighbors)) return r;
+        if (isPointClosestTo(r, m)) return r;
     }
     throw FATALERROR("Can't find random position in cell");
 }
@@ -941,9 +965,71 @@ int VoronoiMeshSnapshot::cellIndex(Position bfr) const
 
 ////////////////////////////////////////////////////////////////////
 
+int VoronoiMeshSnapshot::cellIndex(Position bfr, int mhint) const
+{
+    // if there is no hint, use the search tree
+    if (mhint<0) return cellIndex(bfr);
+
+    // make sure the position is inside the domain
+    if (!_extent.contains(bfr)) return -1;
+
+    // walk towards the point, moving to the neighbor with the nearest site until no neighbor is nearer
+    int m = mhint;
+    double mdist = _cells[m]->squaredDistanceTo(bfr);
+    while (true)
+    {
+        int mnext = m;
+        int iend = _nbbeginv[m+1];
+        for (int i=_nbbeginv[m]; i!=iend; i++)
+        {
+            int id = _nbv[i];
+            if (id>=0)
+            {
+                double idist = _cells[id]->squaredDistanceTo(bfr);
+                if (idist < mdist)
+                {
+                    mnext = id;
+                    mdist = idist;
+                }
+            }
+        }
+        if (mnext == m) return m;
+        m = mnext;
+    }
+}
+
+////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // the snapshot and the index of the cell most recently located by coherentCellIndex() in each thread
+    thread_local const VoronoiMeshSnapshot* t_snapshot = nullptr;
+    thread_local int t_m = -1;
+}
+
+////////////////////////////////////////////////////////////////////
+
+int VoronoiMeshSnapshot::coherentCellIndex(Position bfr) const
+{
+    // use the previously located cell as a hint if it belongs to this snapshot and is near the point
+    int mhint = -1;
+    if (t_snapshot == this && t_m < static_cast<int>(_cells.size()) && _cells[t_m]->contains(bfr)) mhint = t_m;
+
+    // locate the cell and remember it for the next call
+    int m = cellIndex(bfr, mhint);
+    if (m>=0)
+    {
+        t_snapshot = this;
+        t_m = m;
+    }
+    return m;
+}
+
+////////////////////////////////////////////////////////////////////
+
 Vec VoronoiMeshSnapshot::velocity(Position bfr) const
 {
-    int m = cellIndex(bfr);
+    int m = coherentCellIndex(bfr);
     return m>=0 ? velocity(m) : Vec();
 }
 
@@ -951,7 +1037,7 @@ Vec VoronoiMeshSnapshot::velocity(Position bfr) const
 
 double VoronoiMeshSnapshot::velocityDispersion(Position bfr) const
 {
-    int m = cellIndex(bfr);
+    int m = coherentCellIndex(bfr);
     return m>=0 ? velocityDispersion(m) : 0.;
 }
 
@@ -959,7 +1045,7 @@ double VoronoiMeshSnapshot::velocityDispersion(Position bfr) const
 
 void VoronoiMeshSnapshot::parameters(Position bfr, Array& params) const
 {
-    int m = cellIndex(bfr);
+    int m = coherentCellIndex(bfr);
     if (m>=0) parameters(m, params);
     else params.resize(numParameters());
 }
@@ -968,7 +1054,7 @@ void VoronoiMeshSnapshot::parameters(Position bfr, Array& params) const
 
 double VoronoiMeshSnapshot::density(Position bfr) const
 {
-    int m = cellIndex(bfr);
+    int m = coherentCellIndex(bfr);
     return m>=0 ? _rhov[m] : 0;
 }
 
@@ -997,26 +1083,22 @@ void VoronoiMeshSnapshot::path(SpatialGridPath* path) const
 
     // Get the index of the cell containing the current position;
     // if the position is not inside the grid, return an empty path
-    int mr = cellIndex(r);
+    int mr = coherentCellIndex(r);
     if (mr<0) return path->clear();
 
     // Start the loop over cells/path segments until we leave the grid
     while (mr>=0)
     {
-        // get the site position for this cell
-        Vec pr = _cells[mr]->position();
-
         // initialize the smallest nonnegative intersection distance and corresponding index
         double sq = DBL_MAX;          // very large, but not infinity (so that infinite si values are discarded)
         const int NO_INDEX = -99;     // meaningless cell index
         int mq = NO_INDEX;
 
         // loop over the list of neighbor indices
-        const vector<int>& mv = _cells[mr]->neighbors();
-        int n = mv.size();
-        for (int i=0; i<n; i++)
+        int iend = _nbbeginv[mr+1];
+        for (int i=_nbbeginv[mr]; i!=iend; i++)
         {
-            int mi = mv[i];
+            int mi = _nbv[i];
 
             // declare the intersection distance for this neighbor (init to a value that will be rejected)
             double si = 0;
@@ -1024,23 +1106,17 @@ void VoronoiMeshSnapshot::path(SpatialGridPath* path) const
             // --- intersection with neighboring cell
             if (mi>=0)
             {
-                // get the site position for this neighbor
-                Vec pi = _cells[mi]->position();
-
-                // calculate the (unnormalized) normal on the bisecting plane
-                Vec n = pi - pr;
+                // get the precomputed bisecting plane between the sites of the current cell and this neighbor
+                const Face& face = _facev[i];
 
                 // calculate the denominator of the intersection quotient
-                double ndotk = Vec::dot(n,bfk);
+                double ndotk = Vec::dot(face.n,bfk);
 
                 // if the denominator is negative the intersection distance is negative, so don't calculate it
                 if (ndotk > 0)
                 {
-                    // calculate a point on the bisecting plane
-                    Vec p = 0.5 * (pi + pr);
-
                     // calculate the intersection distance
-                    si = Vec::dot(n,p-r) / ndotk;
+                    si = (face.d - Vec::dot(face.n,r)) / ndotk;
                 }
             }
 
@@ -1071,12 +1147,13 @@ void VoronoiMeshSnapshot::path(SpatialGridPath* path) const
         if (mq == NO_INDEX)
         {
             r += bfk*_eps;
-            mr = cellIndex(r);
+            mr = cellIndex(r, mr);
         }
         // otherwise add a path segment and set the current point to the exit point
         else
         {
             path->addSegment(mr, sq);
+            if (path->atSegmentLimit()) return;
             r += (sq+_eps)*bfk;
             mr = mq;
         }
@@ -187,8 +187,19 @@ private:
     void buildSearch();
 
     /** This private function returns true if the given point is closer to the site with index m
-        than to the sites with indices ids. */
-    bool isPointClosestTo(Vec r, int m, const vector<int>& ids) const;
+        than to the sites of the neighbors of cell m. */
+    bool isPointClosestTo(Vec r, int m) const;
+
+    /** This private function returns the index of the cell containing the specified point, or -1
+        if the point is outside the domain. It remembers the result for each execution thread, and
+        uses the cell located by the previous call in the same thread as a hint for the walk
+        performed by the cellIndex(Position, int) function, provided that the point lies inside
+        the bounding box of that cell. Otherwise it uses the search tree. This accelerates
+        sequences of spatially coherent queries, such as the density samples taken in a given
+        cell of another spatial grid during setup, or the paths that start at the same
+        interaction point for the peel-off towards each instrument and for the continued
+        propagation after scattering. */
+    int coherentCellIndex(Position bfr) const;
 
     //====================== Output =====================
 
@@ -276,6 +287,23 @@ public:
         cellIndex() function causes undefined behavior. */
     int cellIndex(Position bfr) const;
 
+    /** This function returns the cell index \f$0\le m \le N_{cells}-1\f$ for the cell containing
+        the specified point \f${\bf{r}}\f$, using the cell with index \f$m_\mathrm{hint}\f$ as a
+        starting point. If the point is outside the domain, the function returns -1. If the hint
+        is negative, the function simply returns the result of the cellIndex() function without
+        hint.
+
+        Starting from the hint cell, the function repeatedly moves to the neighboring cell with the
+        site nearest to the specified point, until none of the neighbors has a site that is nearer
+        to the point than the site of the current cell. Because the distance to the point
+        decreases strictly with each step, the walk always terminates, and because the Voronoi
+        cells are convex, the final cell contains the point. The walk takes a number of steps
+        proportional to the number of cells between the hint cell and the target cell, so this
+        function is faster than the search tree only if the hint is near the point. This is the
+        case, for example, when sampling random positions within a cell or when consecutive
+        queries are otherwise spatially coherent. */
+    int cellIndex(Position bfr, int mhint) const;
+
     /** This function returns the velocity of the cell containing the specified point
         \f${\bf{r}}\f$. If the point is outside the domain, the function returns zero velocity. If
         the velocity is not being imported, the behavior is undefined. */
@@ -321,7 +349,8 @@ public:
         so, the current point is simply initialized to the start point. If not, the function
         computes the path segment to the first intersection with one of the domain walls and moves
         the current point inside the domain. Finally the function determines the current cell, i.e.
-        the cell containing the current point.
+        the cell containing the current point, using the cell located by the previous query in the
+        same thread as a hint if possible (see the coherentCellIndex() function).
 
         In the second stage, the function loops over the algorithm that computes the exit point
         from the current cell, i.e. the intersection of the ray formed by the current point and
@@ -332,7 +361,7 @@ public:
         the path is complete and the loop is terminated. If no exit point is found, which shouldn't
         happen too often, this must be due to computational inaccuracies. In that case, no path
         segment is added, the current point is advanced by a small amount, and the new current cell
-        is determined by calling the function whichcell().
+        is determined by walking from the current cell (see the cellIndex(Position, int) function).
 
         The algorithm that computes the exit point has the following input data:
         <TABLE>
@@ -380,7 +409,10 @@ public:
         of the plane can then be written as \f[\mathbf{n}\cdot(\mathbf{x}-\mathbf{p})=0.\f]
         Substituting \f$\mathbf{x}=\mathbf{r}+s_i\,\mathbf{k}\f$ and solving for \f$s_i\f$ provides
         \f[s_i=\frac{\mathbf{n}\cdot(\mathbf{p}-\mathbf{r})}{\mathbf{n}\cdot\mathbf{k}}.\f]
-        If \f$\mathbf{n}\cdot\mathbf{k}=0\f$ the line and the plane are parallel and there
+        The normal \f$\mathbf{n}\f$ and the offset \f$d=\mathbf{n}\cdot\mathbf{p}\f$ are
+        precomputed for all neighbors when the mesh is built, and stored in cell order next to the
+        neighbor indices, so that the function merely evaluates
+        \f$s_i=(d-\mathbf{n}\cdot\mathbf{r})/(\mathbf{n}\cdot\mathbf{k})\f$. If \f$\mathbf{n}\cdot\mathbf{k}=0\f$ the line and the plane are parallel and there
         is no intersection. In that case no \f$s_i\f$ is added to the set of candidate
         exit points.
 
@@ -402,6 +434,14 @@ private:
     // data members initialized when processing snapshot input and further completed by BuildMesh()
     vector<Cell*> _cells;           // cell objects, indexed on m
 
+    // data members initialized by BuildMesh(); the neighbors of cell m are listed at indices _nbbeginv[m] up to
+    // (but not including) _nbbeginv[m+1] in the other vectors, where negative indices refer to domain walls;
+    // the bisecting plane between the sites of cell m and neighbor mi contains the points x with n.x = d
+    struct Face { Vec n; double d; };
+    vector<int> _nbbeginv;          // index of the first neighbor in _nbv and _facev for each cell, plus one extra
+    vector<int> _nbv;               // neighbor indices for all cells
+    vector<Face> _facev;            // bisecting plane with each neighbor for all cells; unused for domain walls
+
     // data members initialized when processing snapshot input, but only if a density policy has been set
     Array _rhov;                    // density for each cell (not normalized)
     Array _cumrhov;                 // normalized cumulative density distribution for cells
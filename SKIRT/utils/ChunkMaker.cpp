@@ -15,9 +15,12 @@ ChunkMaker::ChunkMaker()
 
 void ChunkMaker::initialize(size_t maxIndex, int numThreads, int numProcs)
 {
-    // Determine the chunk size
-    const size_t numChunksPerThread = 8;   // empirical multiplicator to achieve acceptable load balancing
-    _chunkSize = max(static_cast<size_t>(1), maxIndex / (numThreads*numProcs*numChunksPerThread));
+    // Determine the parameters for the chunk size calculation
+    const size_t numChunksPerThread = 4;        // divisor for guided chunk size relative to number of threads
+    const size_t minNumChunksPerThread = 32;    // upper limit for number of chunks per thread at minimum size
+    size_t numTotalThreads = numThreads*numProcs;
+    _divisor = numTotalThreads*numChunksPerThread;
+    _minChunkSize = max(static_cast<size_t>(1), maxIndex / (numTotalThreads*minNumChunksPerThread));
 
     // Initialize the other data members
     _maxIndex = maxIndex;
@@ -28,24 +31,32 @@ void ChunkMaker::initialize(size_t maxIndex, int numThreads, int numProcs)
 
 bool ChunkMaker::next(size_t& firstIndex, size_t& numIndices)
 {
-    size_t first = _nextIndex.fetch_add(_chunkSize);
-    if (first < _maxIndex)
+    // determine the chunk size from the number of remaining indices and atomically claim the chunk;
+    // if another thread claimed a chunk in the mean time, the compare-exchange operation fails,
+    // updates our copy of the next index, and we try again
+    size_t first = _nextIndex.load();
+    size_t num;
+    do
     {
-        firstIndex = first;
-        numIndices = min(_chunkSize, _maxIndex-first);
-        return true;
+        if (first >= _maxIndex) return false;
+        size_t remaining = _maxIndex-first;
+        num = min(remaining, max(_minChunkSize, remaining/_divisor));
     }
-    return false;
+    while (!_nextIndex.compare_exchange_weak(first, first+num));
+
+    firstIndex = first;
+    numIndices = num;
+    return true;
 }
 
 //////////////////////////////////////////////////////////////////////
 
 bool ChunkMaker::callForNext(const std::function<void (size_t, size_t)>& target)
 {
-    size_t first = _nextIndex.fetch_add(_chunkSize);
-    if (first < _maxIndex)
+    size_t firstIndex, numIndices;
+    if (next(firstIndex, numIndices))
     {
-        target(first, min(_chunkSize, _maxIndex-first));
+        target(firstIndex, numIndices);
         return true;
     }
     return false;
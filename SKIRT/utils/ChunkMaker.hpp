@@ -20,7 +20,15 @@
     chunk and the number of indices in the chunk, and it is expected to iterate over the specified
     index range. The chunk sizes are determined by the heuristic in the ChunkMaker object to
     achieve optimal load balancing given the available parallel resources, while still maximally
-    reducing the overhead of handing out the chunks. */
+    reducing the overhead of handing out the chunks.
+
+    The ChunkMaker class implements a guided self-scheduling policy. The size of each chunk is
+    proportional to the number of indices remaining at the time the chunk is handed out, divided by
+    a multiple of the number of parallel execution threads (across all processes). Consequently,
+    chunks are large at the beginning of the range, minimizing overhead, and shrink towards the end
+    of the range, so that execution threads finish at approximately the same time even if the cost
+    of the tasks varies substantially across the range. The chunk size is limited from below to
+    avoid excessive overhead for the final chunks. */
 class ChunkMaker
 {
 public:
@@ -48,7 +56,8 @@ public:
     bool callForNext(const std::function<void(size_t firstIndex, size_t numIndices)>& target);
 
 private:
-    size_t _chunkSize{0};               // the number of indices in all but the last chunk
+    size_t _minChunkSize{0};            // the minimum number of indices in all but the last chunk
+    size_t _divisor{1};                 // the divisor applied to the number of remaining indices
     size_t _maxIndex{0};                // the maximum index (i.e. limiting the last chunk)
     std::atomic<size_t> _nextIndex{0};  // the first index of the next available chunk
 };
@@ -74,6 +74,25 @@ void PhotonPacket::launchEmissionPeelOff(const PhotonPacket* pp, Direction bfk)
 
 ////////////////////////////////////////////////////////////////////
 
+void PhotonPacket::launchWavelengthSibling(const PhotonPacket* pp, double lambda, double L)
+{
+    _lambda = lambda;
+    _W = L * lambda;
+    _lambda0 = lambda;
+    _bvi = pp->_bvi;
+    _adi = pp->_adi;
+    _ppi = pp->_ppi;
+    _compIndex = pp->_compIndex;
+    _historyIndex = pp->_historyIndex;
+    _nscatt = 0;
+    setPosition(pp->position());
+    setDirection(pp->direction());
+    static_cast<StokesVector&>(*this) = *pp;
+    _hasObservedOpticalDepth = false;
+}
+
+////////////////////////////////////////////////////////////////////
+
 void PhotonPacket::launchScatteringPeelOff(const PhotonPacket* pp, Direction bfk, Vec bfv, double w)
 {
     if (bfv.isNull()) _lambda = pp->_lambda;
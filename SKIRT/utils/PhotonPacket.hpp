@@ -116,6 +116,20 @@ public:
         its previous life cycle is lost. The base photon packet remains unchanged. */
     void launchEmissionPeelOff(const PhotonPacket* pp, Direction bfk);
 
+    /** This function initializes the photon packet as a wavelength sibling of the specified base
+        photon packet, i.e. a packet emitted in the same event as the base packet but carrying a
+        different wavelength and luminosity. It is used for launching a group of packets with the
+        discrete wavelengths of an oligochromatic simulation, which then all share the same launch
+        position, propagation direction and polarization state. The function copies the interface
+        pointers, emission origin, history index, position, direction and polarization state from
+        the base packet, and sets the wavelength and weight corresponding to the specified
+        wavelength and luminosity. The arguments must describe a source without kinematics, so that
+        no Doppler shift needs to be applied.
+
+        The current path of the base photon packet is not copied; use the copyPath() function for
+        that purpose if the path is still valid. The base photon packet remains unchanged. */
+    void launchWavelengthSibling(const PhotonPacket* pp, double lambda, double L);
+
     /** This function initializes a peel off photon packet being sent to an instrument for a
         scattering event. The arguments specify the base photon packet from which the peel off
         derives, the direction towards the instrument, the bulk velocity of the scatterer, and the
@@ -34,17 +34,7 @@ SpatialGridPath::SpatialGridPath()
 void SpatialGridPath::clear()
 {
     _segments.clear();
-}
-
-////////////////////////////////////////////////////////////////////
-
-void SpatialGridPath::addSegment(int m, double ds)
-{
-    if (ds>0)
-    {
-        double s = !_segments.empty() ? _segments.back().s : 0.;
-        _segments.push_back(Segment{m, ds, s+ds, 0.});
-    }
+    _complete = false;
 }
 
 ////////////////////////////////////////////////////////////////////
@@ -46,14 +46,14 @@ public:
     SpatialGridPath();
 
     /** This function sets the initial position of the path to a new value. */
-    void setPosition(const Position& bfr) { _bfr = bfr; }
+    void setPosition(const Position& bfr) { _bfr = bfr; _complete = false; }
 
     /** This function sets the propagation direction along the path to a new value. */
-    void setDirection(const Direction& bfk) { _bfk = bfk; }
+    void setDirection(const Direction& bfk) { _bfk = bfk; _complete = false; }
 
     /** This function propagates the initial position of the path over a distance \f$s\f$. In other
         words, it updates the position from \f${\bf{r}}\f$ to \f${\bf{r}}+s\,{\bf{k}}\f$. */
-    void propagatePosition(double s) { _bfr += s*_bfk; }
+    void propagatePosition(double s) { _bfr += s*_bfk; _complete = false; }
 
     /** This function returns the initial position of the path. */
     Position position() const { return _bfr; }
@@ -61,15 +61,78 @@ public:
     /** This function returns the propagation direction along the path. */
     Direction direction() const { return _bfk; }
 
+    /** This function specifies whether the grid may skip regions of space that contain no material
+        when calculating the path. If this flag is enabled, a spatial grid that has been informed
+        about its empty cells (see SpatialGrid::setEmptyCells()) may cover a series of consecutive
+        empty cells with a single segment that has cell index \f$m=-1\f$. This is appropriate
+        only if the client does not need to store information in the individual cells crossed by
+        the path. By default, the flag is disabled. */
+    void setSkipEmptyCells(bool skip) { _skipEmptyCells = skip; }
+
+    /** This function returns true if the grid may skip regions of space that contain no material
+        when calculating the path, and false otherwise. */
+    bool skipEmptyCells() const { return _skipEmptyCells; }
+
+    /** This function sets the number of segments after which the grid may stop calculating the
+        path, even if the path has not yet left the grid. Spatial grids that honor this limit check
+        the atSegmentLimit() function after adding each segment; other grids always calculate the
+        complete path. In both cases, the last segment in the path ends at a cell border, so that a
+        client can resume the calculation by propagating the initial position to the end of the
+        path and calculating a new path from there. Specifying zero removes the limit, which is
+        also the default. */
+    void setSegmentLimit(size_t numSegments)
+    {
+        _segmentLimit = numSegments ? numSegments : std::numeric_limits<size_t>::max();
+    }
+
+    /** This function returns true if the path contains at least the number of segments specified
+        through the setSegmentLimit() function, and false otherwise. */
+    bool atSegmentLimit() const { return _segments.size() >= _segmentLimit; }
+
     // ------- Adding path segments -------
 
     /** This function removes all path segments, resulting in an empty path with the original
         initial position and propagation direction. */
     void clear();
 
+    /** This function ensures that the path can hold the specified number of segments in addition
+        to the segments it already contains without reallocating memory. Grids that know an upper
+        limit for the number of segments in a path can call this function before adding segments.
+        */
+    void reserve(size_t numSegments) { _segments.reserve(_segments.size() + numSegments); }
+
     /** This function adds a segment in cell \f$m\f$ with length \f$\Delta s\f$ to the path.
-        If \f$\Delta s\le 0\f$, the function does nothing. */
-    void addSegment(int m, double ds);
+        If \f$\Delta s\le 0\f$, the function does nothing. The function is defined inline
+        because it is called for each cell crossed by a path. */
+    void addSegment(int m, double ds)
+    {
+        if (ds>0)
+        {
+            double s = !_segments.empty() ? _segments.back().s : 0.;
+            _segments.push_back(Segment{m, ds, s+ds, 0.});
+        }
+    }
+
+    /** This function adds a segment with length \f$\Delta s\f$ that is not associated with any
+        cell, i.e. with cell index \f$m=-1\f$, to the path. If the last segment in the path is
+        also not associated with a cell, the function extends that segment rather than adding a new
+        one. If \f$\Delta s\le 0\f$, the function does nothing. */
+    void addEmptySegment(double ds)
+    {
+        if (ds>0)
+        {
+            if (!_segments.empty() && _segments.back().m < 0)
+            {
+                _segments.back().ds += ds;
+                _segments.back().s += ds;
+            }
+            else
+            {
+                double s = !_segments.empty() ? _segments.back().s : 0.;
+                _segments.push_back(Segment{-1, ds, s+ds, 0.});
+            }
+        }
+    }
 
     /** This function clears the path, adds any segments needed to move the initial position along
         the propagation direction (both specified in the constructor) inside a given box, and
@@ -81,6 +144,31 @@ public:
         the box. */
     Position moveInside(const Box &box, double eps);
 
+    /** This function marks the current segments as representing the complete path for the current
+        initial position and propagation direction, so that clients can reuse the geometric details
+        of the path instead of asking the spatial grid to calculate them again. The mark is removed
+        when the path is cleared or when its initial position or propagation direction is changed.
+        */
+    void markComplete() { _complete = true; }
+
+    /** This function returns true if the current segments have been marked as representing the
+        complete path for the current initial position and propagation direction, and false
+        otherwise. */
+    bool isComplete() const { return _complete; }
+
+    /** This function replaces the initial position, the propagation direction and the segments of
+        this path by those of the specified path, including the mark indicating whether the
+        segments represent the complete path. This allows multiple objects that share the same
+        geometry (e.g. photon packets that differ only in wavelength) to obtain the path from a
+        single calculation. */
+    void copyPath(const SpatialGridPath* other)
+    {
+        _bfr = other->_bfr;
+        _bfk = other->_bfk;
+        _segments = other->_segments;
+        _complete = other->_complete;
+    }
+
     // ------- Retrieving path segments -------
 
     // basic data structure holding information about a given segment in the path
@@ -147,6 +235,9 @@ private:
     Position _bfr;
     Direction _bfk;
     vector<Segment> _segments;
+    bool _skipEmptyCells{false};
+    bool _complete{false};
+    size_t _segmentLimit{std::numeric_limits<size_t>::max()};
     int _interactionCellIndex{-1};
     double _interactionDistance{0.};
 };